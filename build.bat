@@ -16,5 +16,16 @@ set LNK_DIR=/LIBPATH:.\thirdparty\SDL2\lib\x64
 
 cl %CFLAGS% %INC_DIR% %SOURCES% %OUT_DIR% /link %LNK_DIR% %LIBS% /SUBSYSTEM:CONSOLE
 
+echo ----------------------------------------
+echo Build bench ...
+echo ----------------------------------------
+
+set TARGET=voxel_bench
+set BENCH_CFLAGS=/std:c11 /W2 /nologo /O2 /Zi /EHsc
+set SOURCES=src\bench_all.c
+set OUT_DIR=/Fo.\build\ /Fe.\build\%TARGET% /Fm.\build\
+
+cl %BENCH_CFLAGS% %INC_DIR% %SOURCES% %OUT_DIR% /link %LNK_DIR% %LIBS% /SUBSYSTEM:CONSOLE
+
 xcopy /y .\thirdparty\SDL2\lib\x64\SDL2.dll .\build
 xcopy /y /i /s /e .\res .\build\res
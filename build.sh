@@ -0,0 +1,15 @@
+#!/bin/sh
+
+mkdir -p ./build
+
+echo ----------------------------------------
+echo Build bench ...
+echo ----------------------------------------
+
+TARGET=voxel_bench
+CFLAGS="-std=c11 -Wall -O2 -g"
+LIBS="$(sdl2-config --libs) -lm"
+SOURCES="src/bench_all.c"
+INC_DIR="-I./src -I./thirdparty $(sdl2-config --cflags)"
+
+cc $CFLAGS $INC_DIR $SOURCES -o ./build/$TARGET $LIBS
@@ -5,9 +5,13 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TextCoord;
+flat in vec2 Tile;
 
 uniform sampler2D atlas;
 
+// NOTE: TILE_DIM / ATLAS_W and TILE_DIM / ATLAS_H
+const vec2 tileSize = vec2(32.0 / 512.0, 32.0 / 512.0);
+
 void main() {
     // light pos
     vec3 lightDir = normalize(-vec3(-0.3, -0.6, -0.7));
@@ -21,6 +25,11 @@ void main() {
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * lightColor;
 
+    // atlas coordinates, the gradients come from the unwrapped coordinates to avoid mip seams
+    vec2 local = vec2(fract(TextCoord.x), 1.0 - fract(TextCoord.y));
+    vec2 uv = (Tile + local) * tileSize;
+    vec2 grad = vec2(TextCoord.x, -TextCoord.y) * tileSize;
+
     vec3 result = (ambient + diffuse);
-    FragColor = texture(atlas, TextCoord) * vec4(result, 1.0);
+    FragColor = textureGrad(atlas, uv, dFdx(grad), dFdy(grad)) * vec4(result, 1.0);
 }
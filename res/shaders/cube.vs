@@ -1,22 +1,59 @@
 #version 330 core
 
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNor;
-layout (location = 2) in vec2 aTex;
+// NOTE: Packed vertex, see Vertex in gpu.h
+layout (location = 0) in uvec2 aData;
 
 
-uniform mat4 model;
+// NOTE: World position (x, z) of the chunk of every slot
+uniform samplerBuffer chunkOrigins;
 uniform mat4 view;
 uniform mat4 proj;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TextCoord;
+flat out vec2 Tile;
+
+// NOTE: Same order as VoxelBlockFace
+const vec3 faceNormals[6] = vec3[6](
+    vec3(0, 0, -1),
+    vec3(0, 0, 1),
+    vec3(1, 0, 0),
+    vec3(-1, 0, 0),
+    vec3(0, 1, 0),
+    vec3(0, -1, 0)
+);
+
+const float voxelDim = 1.0;
+const uint atlasCols = 16u;
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNor;  
-    TextCoord = aTex;
+    vec3 p = vec3(float(aData.x & 0x1fu),
+                  float((aData.x >> 5u) & 0x1ffu),
+                  float((aData.x >> 14u) & 0x1fu));
+    uint face = (aData.x >> 19u) & 0x7u;
+    uint tile = aData.y & 0xffu;
+    uint slot = (aData.y >> 8u) & 0xfffu;
+
+    vec3 aPos = (p - 0.5) * voxelDim;
+    vec3 aNor = faceNormals[face];
+
+    vec2 origin = texelFetch(chunkOrigins, int(slot)).xy;
+    vec3 worldPos = aPos + vec3(origin.x, 0.0, origin.y);
+
+    FragPos = worldPos;
+    Normal = aNor;
+    Tile = vec2(float(tile % atlasCols), float(tile / atlasCols));
+
+    // NOTE: Faces can span many voxels, project the chunk position into the face plane so the
+    // tile repeats once per voxel
+    if(abs(aNor.x) > 0.5) {
+        TextCoord = vec2(-aNor.x * p.z, p.y);
+    } else if(abs(aNor.y) > 0.5) {
+        TextCoord = vec2(p.x, -p.z);
+    } else {
+        TextCoord = vec2(p.x, p.y);
+    }
 
-    gl_Position = proj * view * model * vec4(aPos, 1.0);
+    gl_Position = proj * view * vec4(worldPos, 1.0);
 }
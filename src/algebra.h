@@ -613,4 +613,55 @@ static inline b32 m4_inverse2(const float m[16], float invOut[16]) {
     return true;
 }
 
+// NOTE: Frustum planes (n.p + d >= 0 inside) extracted from a projection * view matrix
+typedef struct Plane {
+    V3 n;
+    f32 d;
+} Plane;
+
+typedef struct Frustum {
+    Plane planes[6];
+} Frustum;
+
+static inline Plane plane_normalize(Plane p) {
+    f32 len = v3_length(p.n);
+    if(len != 0) {
+        p.n = v3_scale(p.n, 1.0f / len);
+        p.d = p.d / len;
+    }
+    return p;
+}
+
+static inline Frustum frustum_from_m4(M4 a) {
+    f32 *m = a.m;
+    Frustum frustum;
+    for(u32 i = 0; i < 3; ++i) {
+        u32 r   = i << 2;
+        Plane p = {
+            {m[12] + m[r + 0], m[13] + m[r + 1], m[14] + m[r + 2]},
+            m[15] + m[r + 3]
+        };
+        Plane n = {
+            {m[12] - m[r + 0], m[13] - m[r + 1], m[14] - m[r + 2]},
+            m[15] - m[r + 3]
+        };
+        frustum.planes[i * 2 + 0] = plane_normalize(p);
+        frustum.planes[i * 2 + 1] = plane_normalize(n);
+    }
+    return frustum;
+}
+
+// NOTE: Conservative test, can return true for boxes near the frustum corners
+static inline b32 frustum_intersect_aabb(Frustum *frustum, V3 min, V3 max) {
+    for(u32 i = 0; i < 6; ++i) {
+        Plane *p = frustum->planes + i;
+        V3 v     = v3(p->n.x >= 0 ? max.x : min.x, p->n.y >= 0 ? max.y : min.y,
+                      p->n.z >= 0 ? max.z : min.z);
+        if(v3_dot(p->n, v) + p->d < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 #endif // _ALGEBRA_H_
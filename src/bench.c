@@ -0,0 +1,767 @@
+#include "os.h"
+#include "job.h"
+#include "chunk.h"
+#include "chunk_map.h"
+#include "chunk_grid.h"
+#include "noise.h"
+
+#include <string.h>
+
+// NOTE: Headless chunk pipeline benchmark ------------------------------
+
+#define BENCH_MAX_GRID_SIZE 32
+#define BENCH_MAP_CHUNK_COUNT (MAX_CHUNKS_X * MAX_CHUNKS_Y * 2)
+
+typedef struct BenchChunk {
+    Chunk *chunk;
+    // NOTE: Grid neighbors, the mesh job runs once the chunk and all of them are generated
+    Chunk *neighbors[CHUNK_NEIGHBOR_COUNT];
+    struct BenchChunk *dependents[CHUNK_NEIGHBOR_COUNT];
+    JobCounter mesh_dependencies;
+    u64 voxels_ticks;
+    u64 geometry_ticks;
+} BenchChunk;
+
+typedef struct BenchConfig {
+    s32 seed;
+    u32 threads;
+    u32 grid_size;
+    ChunkMesher mesher;
+    b32 job_stress;
+    b32 chunk_map;
+    b32 flythrough;
+    b32 noise;
+} BenchConfig;
+
+typedef struct BenchSpin {
+    u32 iterations;
+    u32 result;
+    JobHandle handle;
+} BenchSpin;
+
+// NOTE: Iterations between the cancellation checks of a spin job
+#define BENCH_SPIN_STAGE 4096
+
+static char *bench_mesher_names[CHUNK_MESHER_COUNT] = {
+    [CHUNK_MESHER_NAIVE]   = "naive",
+    [CHUNK_MESHER_GREEDY]  = "greedy",
+    [CHUNK_MESHER_BITMASK] = "bitmask",
+};
+
+static f64 bench_ticks_to_ms(u64 ticks) {
+    return ((f64)ticks * 1000.0) / (f64)SDL_GetPerformanceFrequency();
+}
+
+static int bench_chunk_generate_job(void *data) {
+    BenchChunk *bench_chunk = (BenchChunk *)data;
+
+    u64 start = SDL_GetPerformanceCounter();
+    chunk_generate_voxels(bench_chunk->chunk);
+    bench_chunk->voxels_ticks = SDL_GetPerformanceCounter() - start;
+
+    job_counter_decrement(&bench_chunk->mesh_dependencies);
+    for(u32 i = 0; i < CHUNK_NEIGHBOR_COUNT; ++i) {
+        if(bench_chunk->dependents[i]) {
+            job_counter_decrement(&bench_chunk->dependents[i]->mesh_dependencies);
+        }
+    }
+
+    return 0;
+}
+
+static int bench_chunk_mesh_job(void *data) {
+    BenchChunk *bench_chunk = (BenchChunk *)data;
+
+    u64 start = SDL_GetPerformanceCounter();
+    chunk_generate_geometry(bench_chunk->chunk, bench_chunk->neighbors);
+    bench_chunk->geometry_ticks = SDL_GetPerformanceCounter() - start;
+
+    return 0;
+}
+
+// NOTE: FNV-1a over the voxels of every chunk, equal across runs and thread counts for the same
+// seed and grid
+static u32 bench_voxels_checksum(Chunk *chunks, u32 count) {
+    static Voxel voxels[CHUNK_TOTAL_SIZE];
+
+    u32 hash = 2166136261u;
+    for(u32 i = 0; i < count; ++i) {
+        chunk_unpack_voxels(chunks + i, voxels);
+        for(u32 j = 0; j < CHUNK_TOTAL_SIZE; ++j) {
+            hash = (hash ^ voxels[j].type) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static void bench_print_stage(char *name, BenchChunk *bench_chunks, u32 count, b32 geometry) {
+    u64 total = 0;
+    u64 min   = (u64)-1;
+    u64 max   = 0;
+
+    for(u32 i = 0; i < count; ++i) {
+        u64 ticks = geometry ? bench_chunks[i].geometry_ticks : bench_chunks[i].voxels_ticks;
+        total += ticks;
+        if(ticks < min)
+            min = ticks;
+        if(ticks > max)
+            max = ticks;
+    }
+
+    printf("  %-24s total %10.3f ms  avg %8.3f ms  min %8.3f ms  max %8.3f ms\n", name,
+           bench_ticks_to_ms(total), bench_ticks_to_ms(total) / (f64)count, bench_ticks_to_ms(min),
+           bench_ticks_to_ms(max));
+}
+
+// NOTE: Mesh the same chunks again with every mesher on the main thread, now that every chunk is
+// generated the borders come from the real neighbors
+static void bench_compare_meshers(Chunk *chunks, u32 grid_size) {
+    u32 count = grid_size * grid_size;
+
+    ChunkMesher mesher_to_restore = chunk_get_mesher();
+
+    u64 triangles[CHUNK_MESHER_COUNT];
+    u64 ticks[CHUNK_MESHER_COUNT];
+
+    for(u32 mesher = 0; mesher < CHUNK_MESHER_COUNT; ++mesher) {
+        chunk_set_mesher(mesher);
+        triangles[mesher] = 0;
+
+        u64 start = SDL_GetPerformanceCounter();
+        for(u32 i = 0; i < count; ++i) {
+            u32 x = i % grid_size;
+            u32 z = i / grid_size;
+
+            Chunk *neighbors[CHUNK_NEIGHBOR_COUNT];
+            neighbors[CHUNK_NEIGHBOR_BACK]  = z > 0 ? chunks + (i - grid_size) : NULL;
+            neighbors[CHUNK_NEIGHBOR_FRONT] = z < grid_size - 1 ? chunks + (i + grid_size) : NULL;
+            neighbors[CHUNK_NEIGHBOR_LEFT]  = x > 0 ? chunks + (i - 1) : NULL;
+            neighbors[CHUNK_NEIGHBOR_RIGHT] = x < grid_size - 1 ? chunks + (i + 1) : NULL;
+
+            chunk_generate_geometry(chunks + i, neighbors);
+            triangles[mesher] += chunks[i].geometry_count / 3;
+        }
+        ticks[mesher] = SDL_GetPerformanceCounter() - start;
+    }
+
+    chunk_set_mesher(mesher_to_restore);
+
+    printf("mesher comparison (single thread, same chunks):\n");
+    for(u32 mesher = 0; mesher < CHUNK_MESHER_COUNT; ++mesher) {
+        f64 triangle_delta = 100.0 * ((f64)triangles[mesher] - (f64)triangles[CHUNK_MESHER_NAIVE]) /
+                             (f64)triangles[CHUNK_MESHER_NAIVE];
+        f64 time_delta = 100.0 * ((f64)ticks[mesher] - (f64)ticks[CHUNK_MESHER_NAIVE]) /
+                         (f64)ticks[CHUNK_MESHER_NAIVE];
+        printf("  %-8s triangles %10llu (%+6.1f%%)  meshing %10.3f ms (%+6.1f%%)  %8.3f ms/chunk\n",
+               bench_mesher_names[mesher], (unsigned long long)triangles[mesher], triangle_delta,
+               bench_ticks_to_ms(ticks[mesher]), time_delta,
+               bench_ticks_to_ms(ticks[mesher]) / (f64)count);
+    }
+}
+
+static void bench_run_chunk_pipeline(BenchConfig *config) {
+    u32 count = config->grid_size * config->grid_size;
+
+    Chunk *chunks           = (Chunk *)malloc(sizeof(Chunk) * count);
+    BenchChunk *bench_chunks = (BenchChunk *)malloc(sizeof(BenchChunk) * count);
+
+    s32 half_grid = (s32)config->grid_size / 2;
+    for(u32 i = 0; i < count; ++i) {
+        Chunk *chunk = chunks + i;
+        chunk_initialize(chunk);
+        chunk->x = (s32)(i % config->grid_size) - half_grid;
+        chunk->z = (s32)(i / config->grid_size) - half_grid;
+
+        bench_chunks[i].chunk          = chunk;
+        bench_chunks[i].voxels_ticks   = 0;
+        bench_chunks[i].geometry_ticks = 0;
+    }
+
+    // NOTE: Same two stages as the game, a chunk is meshed once its neighbors are generated
+    for(u32 i = 0; i < count; ++i) {
+        BenchChunk *bench_chunk = bench_chunks + i;
+        BenchChunk **dependents = bench_chunk->dependents;
+        u32 grid_size           = config->grid_size;
+        u32 x                   = i % grid_size;
+        u32 z                   = i / grid_size;
+
+        dependents[CHUNK_NEIGHBOR_BACK]  = z > 0 ? bench_chunks + (i - grid_size) : NULL;
+        dependents[CHUNK_NEIGHBOR_FRONT] = z < grid_size - 1 ? bench_chunks + (i + grid_size) : NULL;
+        dependents[CHUNK_NEIGHBOR_LEFT]  = x > 0 ? bench_chunks + (i - 1) : NULL;
+        dependents[CHUNK_NEIGHBOR_RIGHT] = x < grid_size - 1 ? bench_chunks + (i + 1) : NULL;
+
+        u32 dependency_count = 1;
+        for(u32 j = 0; j < CHUNK_NEIGHBOR_COUNT; ++j) {
+            bench_chunk->neighbors[j] = dependents[j] ? dependents[j]->chunk : NULL;
+            dependency_count += dependents[j] ? 1 : 0;
+        }
+
+        ThreadJob mesh_job;
+        mesh_job.run    = bench_chunk_mesh_job;
+        mesh_job.args   = (void *)bench_chunk;
+        mesh_job.handle = NULL;
+        job_counter_initialize(&bench_chunk->mesh_dependencies, dependency_count, mesh_job);
+    }
+
+    u64 start = SDL_GetPerformanceCounter();
+
+    job_queue_begin();
+    for(u32 i = 0; i < count; ++i) {
+        ThreadJob job;
+        job.run    = bench_chunk_generate_job;
+        job.args   = (void *)(bench_chunks + i);
+        job.handle = NULL;
+        push_job(job);
+    }
+    job_queue_end();
+
+    u64 end = SDL_GetPerformanceCounter();
+
+    u64 total_vertices    = 0;
+    u64 total_voxels_size = 0;
+    ChunkSectionStats section_stats = { 0 };
+    for(u32 i = 0; i < count; ++i) {
+        total_vertices += chunks[i].geometry_count;
+        total_voxels_size += chunk_get_voxels_size(chunks + i);
+        chunk_get_section_stats(chunks + i, &section_stats);
+    }
+
+    f64 wall_ms      = bench_ticks_to_ms(end - start);
+    f64 wall_seconds = wall_ms / 1000.0;
+
+    printf("chunk pipeline: seed %d, %u threads, %ux%u chunks, %s mesher\n", config->seed,
+           config->threads, config->grid_size, config->grid_size,
+           bench_mesher_names[config->mesher]);
+    printf("  wall time                %10.3f ms\n", wall_ms);
+    printf("  chunks/sec               %10.1f\n", (f64)count / wall_seconds);
+    printf("  voxels/sec               %10.0f\n", ((f64)count * CHUNK_TOTAL_SIZE) / wall_seconds);
+    printf("  vertices emitted         %10llu (%.1f per chunk, %.2f MB)\n",
+           (unsigned long long)total_vertices, (f64)total_vertices / (f64)count,
+           (f64)(total_vertices * sizeof(Vertex)) / (1024.0 * 1024.0));
+    printf("  voxel storage            %10.1f KB per chunk (%.1f KB unpacked)\n",
+           (f64)total_voxels_size / (f64)count / 1024.0,
+           (f64)(CHUNK_TOTAL_SIZE * sizeof(Voxel)) / 1024.0);
+    printf("  voxel checksum           %10x\n", bench_voxels_checksum(chunks, count));
+    printf("  sections                 %10u empty, %u uniform, %u mixed (%u 1 bit, %u 2 bit, "
+           "%u 4 bit)\n",
+           section_stats.type_count[CHUNK_SECTION_EMPTY],
+           section_stats.type_count[CHUNK_SECTION_UNIFORM],
+           section_stats.type_count[CHUNK_SECTION_MIXED], section_stats.bits_count[1],
+           section_stats.bits_count[2], section_stats.bits_count[4]);
+    bench_print_stage("chunk_generate_voxels", bench_chunks, count, false);
+    bench_print_stage("chunk_generate_geometry", bench_chunks, count, true);
+
+    MeshPoolStats mesh_stats = mesh_pool_get_stats();
+    printf("  mesh staging             %10.2f MB used, %.2f MB peak, %.2f MB cached\n",
+           (f64)mesh_stats.used_size / (1024.0 * 1024.0),
+           (f64)mesh_stats.peak_used_size / (1024.0 * 1024.0),
+           (f64)mesh_stats.cached_size / (1024.0 * 1024.0));
+
+    bench_compare_meshers(chunks, config->grid_size);
+
+    for(u32 i = 0; i < count; ++i) {
+        chunk_release(chunks + i);
+    }
+
+    free(bench_chunks);
+    free(chunks);
+}
+
+// NOTE: Busy work with no shared memory so only the scheduler limits the scaling
+static int bench_spin_job(void *data) {
+    BenchSpin *spin = (BenchSpin *)data;
+    u32 x           = spin->iterations;
+    for(u32 i = 0; i < spin->iterations; ++i) {
+        if((i % BENCH_SPIN_STAGE) == 0 && job_is_cancelled(&spin->handle)) {
+            return JOB_CANCELLED;
+        }
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    spin->result = x;
+    return JOB_DONE;
+}
+
+static u64 bench_run_spin_jobs(BenchSpin *spins, u32 count) {
+    u64 start = SDL_GetPerformanceCounter();
+    job_queue_begin();
+    for(u32 i = 0; i < count; ++i) {
+        ThreadJob job;
+        job.run    = bench_spin_job;
+        job.args   = (void *)(spins + i);
+        job.handle = &spins[i].handle;
+        push_job(job);
+    }
+    job_queue_end();
+    return SDL_GetPerformanceCounter() - start;
+}
+
+// NOTE: Push a batch of large jobs and cancel some of them right away, like the chunks that
+// leave the window before they are built. The workers are already running the first jobs
+static void bench_run_job_cancel(BenchConfig *config, BenchSpin *spins) {
+    u32 count      = 256;
+    u32 iterations = 200000;
+
+    printf("job cancellation: %u jobs, %u threads\n", count, config->threads + 1);
+    for(u32 cancel_every = 1; cancel_every <= 4; cancel_every *= 2) {
+        job_system_initialize(config->threads);
+
+        for(u32 i = 0; i < count; ++i) {
+            spins[i].iterations = iterations;
+            spins[i].result     = 0;
+            job_handle_reset(&spins[i].handle);
+        }
+
+        u64 start = SDL_GetPerformanceCounter();
+        job_queue_begin();
+        for(u32 i = 0; i < count; ++i) {
+            ThreadJob job;
+            job.run    = bench_spin_job;
+            job.args   = (void *)(spins + i);
+            job.handle = &spins[i].handle;
+            push_job(job);
+        }
+        for(u32 i = 0; i < count; i += cancel_every) {
+            job_cancel(&spins[i].handle);
+        }
+        job_queue_end();
+        u64 ticks = SDL_GetPerformanceCounter() - start;
+
+        JobStats stats = job_get_stats();
+        job_system_terminate();
+
+        f64 seconds = bench_ticks_to_ms(ticks) / 1000.0;
+        printf("  cancel 1/%u  %10.3f ms  %5llu completed (%10.0f/sec)  %5llu cancelled "
+               "(%10.0f/sec)\n",
+               cancel_every, seconds * 1000.0, (unsigned long long)stats.completed,
+               (f64)stats.completed / seconds, (unsigned long long)stats.cancelled,
+               (f64)stats.cancelled / seconds);
+    }
+}
+
+// NOTE: Run the same batches of small and large jobs with 1 to N threads (the main thread plus
+// the workers) and report the speedup against the single thread run
+static void bench_run_job_stress(BenchConfig *config) {
+    static struct {
+        char *name;
+        u32 count;
+        u32 iterations;
+    } batches[] = {
+        { "small", 32768, 256 },
+        { "large", 256, 200000 },
+    };
+
+    u32 max_count = 0;
+    for(u32 i = 0; i < array_len(batches); ++i) {
+        if(batches[i].count > max_count)
+            max_count = batches[i].count;
+    }
+    BenchSpin *spins = (BenchSpin *)malloc(sizeof(BenchSpin) * max_count);
+
+    printf("job stress: 1 to %u threads\n", config->threads + 1);
+    for(u32 batch = 0; batch < array_len(batches); ++batch) {
+        u64 single_thread_ticks = 0;
+        for(u32 threads = 0; threads <= config->threads; ++threads) {
+            job_system_initialize(threads);
+
+            for(u32 i = 0; i < batches[batch].count; ++i) {
+                spins[i].iterations = batches[batch].iterations;
+                spins[i].result     = 0;
+                job_handle_reset(&spins[i].handle);
+            }
+            u64 ticks = bench_run_spin_jobs(spins, batches[batch].count);
+            if(threads == 0)
+                single_thread_ticks = ticks;
+
+            job_system_terminate();
+
+            f64 ms = bench_ticks_to_ms(ticks);
+            printf("  %-6s %6u jobs  %u threads  %10.3f ms  %12.0f jobs/sec  %5.2fx\n",
+                   batches[batch].name, batches[batch].count, threads + 1, ms,
+                   (f64)batches[batch].count / (ms / 1000.0),
+                   (f64)single_thread_ticks / (f64)ticks);
+        }
+    }
+
+    bench_run_job_cancel(config, spins);
+
+    free(spins);
+}
+
+// NOTE: Probe lengths of the old x * 7 + z * 73 hash chains for the same chunks
+static void bench_chained_hash_stats(Chunk **live, u32 live_count, f64 *average, u32 *max) {
+    static u32 bucket_sizes[BENCH_MAP_CHUNK_COUNT];
+    memset(bucket_sizes, 0, sizeof(bucket_sizes));
+
+    u64 total = 0;
+    *max      = 0;
+    for(u32 i = 0; i < live_count; ++i) {
+        u32 hash = ((u32)live[i]->x * 7 + (u32)live[i]->z * 73) % BENCH_MAP_CHUNK_COUNT;
+        bucket_sizes[hash] += 1;
+        // NOTE: A lookup walks the chain up to the chunk
+        total += bucket_sizes[hash];
+        if(bucket_sizes[hash] > *max)
+            *max = bucket_sizes[hash];
+    }
+    *average = live_count ? (f64)total / (f64)live_count : 0;
+}
+
+// NOTE: Move a load window over the map the way the game does, insert the new chunks of the
+// window, remove the ones that fall out of it plus a margin and look up the whole window
+static void bench_run_chunk_map(void) {
+    s32 radius      = MAX_CHUNKS_X / 2;
+    s32 keep_radius = radius + 2;
+    u32 step_count  = 1024;
+
+    Chunk *chunks     = (Chunk *)malloc(sizeof(Chunk) * BENCH_MAP_CHUNK_COUNT);
+    Chunk **free_list = (Chunk **)malloc(sizeof(Chunk *) * BENCH_MAP_CHUNK_COUNT);
+    Chunk **live      = (Chunk **)malloc(sizeof(Chunk *) * BENCH_MAP_CHUNK_COUNT);
+    u32 free_count    = BENCH_MAP_CHUNK_COUNT;
+    u32 live_count    = 0;
+    for(u32 i = 0; i < BENCH_MAP_CHUNK_COUNT; ++i) {
+        free_list[i] = chunks + i;
+    }
+
+    ChunkMap map;
+    chunk_map_initialize(&map);
+
+    u64 lookup_ticks = 0;
+    u64 lookup_count = 0;
+    f64 probe_total  = 0;
+    u32 probe_max    = 0;
+    f64 chain_total  = 0;
+    u32 chain_max    = 0;
+    s32 center_x     = 0;
+    s32 center_z     = 0;
+
+    for(u32 step = 0; step < step_count; ++step) {
+        // NOTE: Walk diagonally and turn every 128 steps
+        s32 direction = (step / 128) % 4;
+        center_x += (direction == 0 || direction == 3) ? 1 : -1;
+        center_z += (direction == 0 || direction == 1) ? 1 : -1;
+
+        for(u32 i = 0; i < live_count;) {
+            Chunk *chunk = live[i];
+            if(abs(chunk->x - center_x) > keep_radius || abs(chunk->z - center_z) > keep_radius) {
+                chunk_map_remove(&map, chunk);
+                free_list[free_count++] = chunk;
+                live[i]                 = live[--live_count];
+                continue;
+            }
+            ++i;
+        }
+
+        for(s32 x = center_x - radius; x <= center_x + radius; ++x) {
+            for(s32 z = center_z - radius; z <= center_z + radius; ++z) {
+                if(!chunk_map_get(&map, x, z)) {
+                    assert(free_count > 0);
+                    Chunk *chunk = free_list[--free_count];
+                    chunk->x     = x;
+                    chunk->z     = z;
+                    chunk_map_insert(&map, chunk);
+                    live[live_count++] = chunk;
+                }
+            }
+        }
+
+        u64 start = SDL_GetPerformanceCounter();
+        for(s32 x = center_x - radius; x <= center_x + radius; ++x) {
+            for(s32 z = center_z - radius; z <= center_z + radius; ++z) {
+                Chunk *chunk = chunk_map_get(&map, x, z);
+                assert(chunk && chunk->x == x && chunk->z == z);
+                unused(chunk);
+            }
+        }
+        lookup_ticks += SDL_GetPerformanceCounter() - start;
+        lookup_count += (u64)(radius * 2 + 1) * (u64)(radius * 2 + 1);
+
+        ChunkMapStats stats = chunk_map_get_stats(&map);
+        probe_total += stats.average_probe_length;
+        if(stats.max_probe_length > probe_max)
+            probe_max = stats.max_probe_length;
+
+        f64 chain_average;
+        u32 chain_step_max;
+        bench_chained_hash_stats(live, live_count, &chain_average, &chain_step_max);
+        chain_total += chain_average;
+        if(chain_step_max > chain_max)
+            chain_max = chain_step_max;
+    }
+
+    ChunkMapStats stats = chunk_map_get_stats(&map);
+    printf("chunk map: %u steps, %d chunk window, %u chunks live\n", step_count, radius * 2 + 1,
+           stats.count);
+    printf("  lookups                  %10.1f ns per lookup\n",
+           bench_ticks_to_ms(lookup_ticks) * 1000000.0 / (f64)lookup_count);
+    printf("  open addressing probes   %10.2f avg, %u max, %u rebuilds, %u tombstones\n",
+           probe_total / (f64)step_count, probe_max, stats.rebuild_count, stats.tombstone_count);
+    printf("  old hash chain probes    %10.2f avg, %u max\n", chain_total / (f64)step_count,
+           chain_max);
+
+    chunk_map_terminate(&map);
+    free(live);
+    free(free_list);
+    free(chunks);
+}
+
+// NOTE: Fly the load window over the world at a few speeds and time the residency updates
+// (evict, insert) and the lookups of every window chunk and its four neighbors, once with the
+// chunk map and once with the toroidal chunk grid
+static void bench_run_flythrough_with(b32 use_grid, s32 speed, u64 *update_ticks,
+                                      u64 *lookup_ticks) {
+    s32 radius      = MAX_CHUNKS_X / 2;
+    s32 keep_radius = radius + 2;
+    u32 step_count  = 256;
+
+    Chunk *chunks     = (Chunk *)malloc(sizeof(Chunk) * BENCH_MAP_CHUNK_COUNT);
+    Chunk **free_list = (Chunk **)malloc(sizeof(Chunk *) * BENCH_MAP_CHUNK_COUNT);
+    Chunk **live      = (Chunk **)malloc(sizeof(Chunk *) * BENCH_MAP_CHUNK_COUNT);
+    u32 free_count    = BENCH_MAP_CHUNK_COUNT;
+    u32 live_count    = 0;
+    for(u32 i = 0; i < BENCH_MAP_CHUNK_COUNT; ++i) {
+        free_list[i] = chunks + i;
+    }
+
+    ChunkMap map;
+    ChunkGrid *grid = (ChunkGrid *)malloc(sizeof(ChunkGrid));
+    chunk_map_initialize(&map);
+    chunk_grid_initialize(grid);
+
+    *update_ticks = 0;
+    *lookup_ticks = 0;
+    s32 center_x  = 0;
+    for(u32 step = 0; step < step_count; ++step) {
+        center_x += speed;
+
+        u64 start = SDL_GetPerformanceCounter();
+        for(u32 i = 0; i < live_count;) {
+            Chunk *chunk = live[i];
+            if(abs(chunk->x - center_x) > keep_radius || abs(chunk->z) > keep_radius) {
+                if(use_grid)
+                    chunk_grid_remove(grid, chunk);
+                else
+                    chunk_map_remove(&map, chunk);
+                free_list[free_count++] = chunk;
+                live[i]                 = live[--live_count];
+                continue;
+            }
+            ++i;
+        }
+        for(s32 x = center_x - radius; x <= center_x + radius; ++x) {
+            for(s32 z = -radius; z <= radius; ++z) {
+                Chunk *chunk = use_grid ? chunk_grid_get(grid, x, z) : chunk_map_get(&map, x, z);
+                if(!chunk) {
+                    assert(free_count > 0);
+                    chunk    = free_list[--free_count];
+                    chunk->x = x;
+                    chunk->z = z;
+                    if(use_grid)
+                        chunk_grid_insert(grid, chunk);
+                    else
+                        chunk_map_insert(&map, chunk);
+                    live[live_count++] = chunk;
+                }
+            }
+        }
+        u64 middle = SDL_GetPerformanceCounter();
+
+        u32 found = 0;
+        for(s32 x = center_x - radius; x <= center_x + radius; ++x) {
+            for(s32 z = -radius; z <= radius; ++z) {
+                if(use_grid) {
+                    Chunk *chunk = chunk_grid_get(grid, x, z);
+                    found += chunk_grid_get_neighbor(grid, chunk, -1, 0) != NULL;
+                    found += chunk_grid_get_neighbor(grid, chunk, 1, 0) != NULL;
+                    found += chunk_grid_get_neighbor(grid, chunk, 0, -1) != NULL;
+                    found += chunk_grid_get_neighbor(grid, chunk, 0, 1) != NULL;
+                } else {
+                    found += chunk_map_get(&map, x, z) != NULL;
+                    found += chunk_map_get(&map, x - 1, z) != NULL;
+                    found += chunk_map_get(&map, x + 1, z) != NULL;
+                    found += chunk_map_get(&map, x, z - 1) != NULL;
+                    found += chunk_map_get(&map, x, z + 1) != NULL;
+                }
+            }
+        }
+        u64 end = SDL_GetPerformanceCounter();
+        unused(found);
+
+        *update_ticks += middle - start;
+        *lookup_ticks += end - middle;
+    }
+
+    chunk_map_terminate(&map);
+    free(grid);
+    free(live);
+    free(free_list);
+    free(chunks);
+}
+
+static void bench_run_flythrough(void) {
+    s32 speeds[] = { 1, 4, 16 };
+
+    printf("flythrough: 256 steps, %d chunk window\n", MAX_CHUNKS_X + 1);
+    for(u32 i = 0; i < array_len(speeds); ++i) {
+        for(u32 use_grid = 0; use_grid < 2; ++use_grid) {
+            u64 update_ticks, lookup_ticks;
+            bench_run_flythrough_with(use_grid, speeds[i], &update_ticks, &lookup_ticks);
+            printf("  %-5s %2d chunks/step  update %8.3f ms  lookups %8.3f ms\n",
+                   use_grid ? "grid" : "map", speeds[i], bench_ticks_to_ms(update_ticks),
+                   bench_ticks_to_ms(lookup_ticks));
+        }
+    }
+}
+
+// NOTE: Heightmap like inputs (y = 0, x and z on the voxel grid) plus random 3d points, checked
+// against stb_perlin_noise3_seed
+static void bench_run_noise(BenchConfig *config) {
+    u32 count   = 1 << 20;
+    f32 *x      = (f32 *)malloc(sizeof(f32) * count);
+    f32 *y      = (f32 *)malloc(sizeof(f32) * count);
+    f32 *z      = (f32 *)malloc(sizeof(f32) * count);
+    f32 *batch  = (f32 *)malloc(sizeof(f32) * count);
+    f32 *scalar = (f32 *)malloc(sizeof(f32) * count);
+
+    srand(1);
+    for(u32 i = 0; i < count; ++i) {
+        if(i < count / 2) {
+            x[i] = (s32)(i % 1024 - 512) / ((f32)CHUNK_X * 2.0f);
+            y[i] = 0;
+            z[i] = (s32)(i / 1024 - 256) / ((f32)CHUNK_Z * 2.0f);
+        } else {
+            x[i] = ((f32)rand() / (f32)RAND_MAX - 0.5f) * 512.0f;
+            y[i] = ((f32)rand() / (f32)RAND_MAX - 0.5f) * 512.0f;
+            z[i] = ((f32)rand() / (f32)RAND_MAX - 0.5f) * 512.0f;
+        }
+    }
+
+    u8 seed   = (u8)config->seed;
+    u64 start = SDL_GetPerformanceCounter();
+    noise_perlin3_batch_scalar(scalar, x, y, z, count, seed);
+    u64 middle = SDL_GetPerformanceCounter();
+    noise_perlin3_batch(batch, x, y, z, count, seed);
+    u64 end = SDL_GetPerformanceCounter();
+
+    f32 max_error = 0;
+    for(u32 i = 0; i < count; ++i) {
+        f32 error = fabsf(batch[i] - scalar[i]);
+        if(error > max_error)
+            max_error = error;
+    }
+
+    f64 scalar_ms = bench_ticks_to_ms(middle - start);
+    f64 batch_ms  = bench_ticks_to_ms(end - middle);
+    printf("noise: %u points, seed %u, %s batch\n", count, seed, NOISE_SSE2 ? "sse2" : "scalar");
+    printf("  stb scalar               %10.3f ms  %8.1f M points/sec\n", scalar_ms,
+           (f64)count / (scalar_ms * 1000.0));
+    printf("  batch                    %10.3f ms  %8.1f M points/sec  %.2fx\n", batch_ms,
+           (f64)count / (batch_ms * 1000.0), scalar_ms / batch_ms);
+    printf("  max abs error            %10g\n", max_error);
+
+    free(scalar);
+    free(batch);
+    free(z);
+    free(y);
+    free(x);
+}
+
+static void bench_print_usage(void) {
+    printf("usage: voxel_bench [-seed n] [-threads n] [-grid n] [-mesher naive|greedy|bitmask] [-jobs] "
+           "[-map] [-flythrough] [-noise]\n");
+    printf("  -seed     world seed used by the terrain noise (default 0)\n");
+    printf("  -threads  worker threads besides the main thread (default %d, max %d)\n",
+           MAX_WORKER_THREADS, MAX_WORKER_THREADS);
+    printf("  -grid     side of the square chunk grid to build (default 16, max %d)\n",
+           BENCH_MAX_GRID_SIZE);
+    printf("  -mesher   mesher used by the pipeline run (default greedy)\n");
+    printf("  -jobs     run the job system stress test instead of the chunk pipeline\n");
+    printf("  -map      run the chunk map probe length test instead of the chunk pipeline\n");
+    printf("  -flythrough compare the chunk map and the chunk grid while flying over the world\n");
+    printf("  -noise    compare the batched perlin noise against stb\n");
+}
+
+int main(int argc, char **argv) {
+
+    BenchConfig config = {
+        .seed       = 0,
+        .threads    = MAX_WORKER_THREADS,
+        .grid_size  = 16,
+        .mesher     = CHUNK_MESHER_GREEDY,
+        .job_stress = false,
+        .chunk_map  = false,
+        .flythrough = false,
+        .noise      = false,
+    };
+
+    for(s32 i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+            config.seed = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            config.threads = (u32)atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-grid") == 0 && i + 1 < argc) {
+            config.grid_size = (u32)atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-mesher") == 0 && i + 1 < argc) {
+            char *name = argv[++i];
+            u32 mesher = 0;
+            while(mesher < CHUNK_MESHER_COUNT && strcmp(name, bench_mesher_names[mesher]) != 0) {
+                ++mesher;
+            }
+            if(mesher == CHUNK_MESHER_COUNT) {
+                bench_print_usage();
+                return -1;
+            }
+            config.mesher = mesher;
+        } else if(strcmp(argv[i], "-jobs") == 0) {
+            config.job_stress = true;
+        } else if(strcmp(argv[i], "-map") == 0) {
+            config.chunk_map = true;
+        } else if(strcmp(argv[i], "-flythrough") == 0) {
+            config.flythrough = true;
+        } else if(strcmp(argv[i], "-noise") == 0) {
+            config.noise = true;
+        } else {
+            bench_print_usage();
+            return -1;
+        }
+    }
+
+    if(config.threads > MAX_WORKER_THREADS) {
+        config.threads = MAX_WORKER_THREADS;
+    }
+    if(config.grid_size == 0 || config.grid_size > BENCH_MAX_GRID_SIZE) {
+        bench_print_usage();
+        return -1;
+    }
+
+    if(config.job_stress) {
+        bench_run_job_stress(&config);
+        return 0;
+    }
+    if(config.chunk_map) {
+        bench_run_chunk_map();
+        return 0;
+    }
+    if(config.flythrough) {
+        bench_run_flythrough();
+        return 0;
+    }
+    if(config.noise) {
+        bench_run_noise(&config);
+        return 0;
+    }
+
+    voxel_block_map_initialize();
+    chunk_set_world_seed(config.seed);
+    chunk_set_mesher(config.mesher);
+    job_system_initialize(config.threads);
+
+    bench_run_chunk_pipeline(&config);
+
+    job_system_terminate();
+    mesh_pool_terminate();
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------
@@ -0,0 +1,13 @@
+// -----------------------------------------------------------------------------
+// NOTE: (Unity Build) Headless benchmark, builds the chunk pipeline without
+// creating a window or an OpenGL context
+// -----------------------------------------------------------------------------
+
+#include "job.c"
+#include "mesh.c"
+#include "voxel.c"
+#include "noise.c"
+#include "chunk.c"
+#include "chunk_map.c"
+#include "chunk_grid.c"
+#include "bench.c"
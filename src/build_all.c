@@ -5,8 +5,12 @@
 #include "os.c"
 #include "gpu.c"
 #include "job.c"
+#include "mesh.c"
 #include "voxel.c"
+#include "noise.c"
 #include "chunk.c"
+#include "chunk_map.c"
+#include "chunk_grid.c"
 #include "camera.c"
 #include "game.c"
 #include "main.c"
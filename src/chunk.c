@@ -1,310 +1,860 @@
 #include "chunk.h"
 #include "job.h"
-
-#define STB_PERLIN_IMPLEMENTATION
-#include <stb_perlin.h>
+#include "noise.h"
 
 extern VoxelBlock voxel_block_map[VOXEL_TYPE_COUNT];
 
-static s32 random(s32 min, s32 max) {
-    f32 scale  = (f32)rand() / (f32)RAND_MAX;
-    s32 result = min + (s32)(scale * (f32)(max - min));
-    // assert(result >= min && result < max);
-    return result;
+static s32 world_seed = 0;
+
+void chunk_set_world_seed(s32 seed) {
+    world_seed = seed;
 }
 
-static inline void add_vertex(Chunk *chunk, V3 pos, V3 normal, V2 uvs) {
-    assert((chunk->geometry_count * sizeof(Vertex)) < MAX_CHUNK_GEOMETRY_SIZE);
-    chunk->geometry[chunk->geometry_count++] = (Vertex){ pos, normal, uvs };
+static ChunkMesher chunk_mesher = CHUNK_MESHER_NAIVE;
+
+void chunk_set_mesher(ChunkMesher mesher) {
+    assert(mesher < CHUNK_MESHER_COUNT);
+    chunk_mesher = mesher;
 }
 
-static inline Voxel *get_chunk_voxel(Chunk *chunk, u32 x, u32 y, u32 z) {
-    if((x < 0) || (x >= CHUNK_X))
-        return NULL;
-    if((y < 0) || (y >= CHUNK_Y))
-        return NULL;
-    if((z < 0) || (z >= CHUNK_Z))
-        return NULL;
+ChunkMesher chunk_get_mesher(void) {
+    return chunk_mesher;
+}
 
-    return &chunk->voxels[z * (CHUNK_Y * CHUNK_X) + y * (CHUNK_X) + x];
+// NOTE: Stateless random numbers, a hash of the world seed, the voxel world coordinates and a
+// stream index (to draw more than one number per voxel). The same voxel always gets the same
+// numbers no matter which thread generates it or in which order
+static inline u32 random_mix(u32 h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
 }
 
-static f32 calculate_xz_height(s32 chunk_x, s32 chunk_z, s32 x, s32 z) {
-    f32 abs_x = (chunk_x * CHUNK_X + x) / ((f32)CHUNK_X * 2.0f);
-    f32 abs_z = (chunk_z * CHUNK_Z + z) / ((f32)CHUNK_Z * 2.0f);
-    f32 noise = (stb_perlin_noise3(abs_x, 0, abs_z, 0, 0, 0) + 1) / 2.0f;
-    f32 h     = 20 + noise * (u32)((CHUNK_Y / 2) - 50);
-    assert(h >= 0 && h < CHUNK_Y);
+static inline u32 random_hash(s32 x, s32 y, s32 z, u32 stream) {
+    u32 h = random_mix((u32)world_seed + stream * 0x9e3779b9u);
+    h     = random_mix(h ^ (u32)x);
+    h     = random_mix(h ^ (u32)y);
+    h     = random_mix(h ^ (u32)z);
     return h;
 }
 
-void chunk_generate_voxels(Chunk *chunk) {
-    unused(random);
+static inline s32 random_range(s32 x, s32 y, s32 z, u32 stream, s32 min, s32 max) {
+    return min + (s32)(random_hash(x, y, z, stream) % (u32)(max - min));
+}
 
-    if(!chunk) {
-        return;
+static inline void add_vertex(Chunk *chunk, Vertex vertex) {
+    assert(chunk->geometry_count < MAX_CHUNK_VERTICES);
+    u32 index = chunk->geometry_count - chunk->staged_count;
+    if(index == chunk->geometry_capacity) {
+        if(chunk->geometry && chunk->geometry == chunk->staging) {
+            // NOTE: The staging memory is full, leave it as it is (it is write only) and continue
+            // the mesh in the mesh pool
+            chunk->staged_count = chunk->geometry_count;
+            chunk->geometry     = mesh_alloc(1, &chunk->geometry_capacity);
+            index               = 0;
+        } else {
+            chunk->geometry = mesh_grow(chunk->geometry, index + 1, &chunk->geometry_capacity);
+        }
     }
+    vertex.tile |= chunk->vertex_slot << VERTEX_SLOT_SHIFT;
+    chunk->geometry[index] = vertex;
+    chunk->geometry_count += 1;
+}
 
-    for(s32 x = 0; x < CHUNK_X; ++x) {
-        for(s32 z = 0; z < CHUNK_Z; ++z) {
+// NOTE: Voxels are laid out y major so every section is a contiguous run of CHUNK_SECTION_SIZE
+static inline u32 get_voxel_index(u32 x, u32 y, u32 z) {
+    return y * (CHUNK_X * CHUNK_Z) + z * (CHUNK_X) + x;
+}
 
-            f32 h = calculate_xz_height(chunk->x, chunk->z, x, z);
+static inline void chunk_extend_bounds(Chunk *chunk, u32 min_y, u32 max_y) {
+    if(min_y < chunk->min_y)
+        chunk->min_y = min_y;
+    if(max_y > chunk->max_y)
+        chunk->max_y = max_y;
+}
 
-            for(s32 y = 0; y < CHUNK_Y; ++y) {
+// NOTE: Paletted voxel storage -----------------------------------------
 
-                Voxel *voxel = get_chunk_voxel(chunk, x, y, z);
+static inline u32 chunk_section_bits(u32 palette_count) {
+    if(palette_count <= 1)
+        return 0;
+    if(palette_count <= 2)
+        return 1;
+    if(palette_count <= 4)
+        return 2;
+    return 4;
+}
 
-                if(y <= h && y < 50) {
+static inline u32 chunk_section_words(u32 bits) {
+    return (CHUNK_SECTION_SIZE * bits) / 32;
+}
 
-                    // NOTE: srand is not thread save
-                    // srand(x * 7 + y * 69 + z * 83);
+static void chunk_section_set_uniform(ChunkSection *section, Voxel voxel) {
+    free(section->data);
+    section->data          = NULL;
+    section->bits          = 0;
+    section->palette[0]    = voxel;
+    section->palette_count = 1;
+    section->type = voxel.type == VOXEL_AIR ? CHUNK_SECTION_EMPTY : CHUNK_SECTION_UNIFORM;
+}
 
-                    voxel->type = VOXEL_STONE;
-                    s32 num     = random(0, 100);
-                    if(num < 6) {
-                        voxel->type = random(VOXEL_BLOCK_MINERAL_BLUE, VOXEL_BLOCK_MINERAL_RED + 1);
-                    }
-                } else if(y < h) {
-                    voxel->type = VOXEL_DIRT;
+static void chunk_section_pack(ChunkSection *section, Voxel *voxels) {
+    u8 palette_index[VOXEL_TYPE_COUNT];
+    memset(palette_index, 0xff, sizeof(palette_index));
+
+    u32 palette_count = 0;
+    Voxel palette[VOXEL_TYPE_COUNT];
+    for(u32 i = 0; i < CHUNK_SECTION_SIZE; ++i) {
+        u8 type = voxels[i].type;
+        if(palette_index[type] == 0xff) {
+            palette_index[type]      = palette_count;
+            palette[palette_count++] = voxels[i];
+        }
+    }
 
-                } else {
-                    voxel->type = VOXEL_AIR;
-                }
-            }
+    if(palette_count == 1) {
+        chunk_section_set_uniform(section, palette[0]);
+        return;
+    }
+
+    u32 bits = chunk_section_bits(palette_count);
+    if(bits != section->bits) {
+        free(section->data);
+        section->data = (u32 *)malloc(chunk_section_words(bits) * sizeof(u32));
+        section->bits = bits;
+    }
+    section->type          = CHUNK_SECTION_MIXED;
+    section->palette_count = palette_count;
+    memcpy(section->palette, palette, sizeof(Voxel) * palette_count);
+
+    u32 per_word = 32 / bits;
+    u32 words    = chunk_section_words(bits);
+    for(u32 word_index = 0; word_index < words; ++word_index) {
+        Voxel *src = voxels + word_index * per_word;
+        u32 word   = 0;
+        for(u32 i = 0; i < per_word; ++i) {
+            word |= (u32)palette_index[src[i].type] << (i * bits);
         }
+        section->data[word_index] = word;
     }
+}
 
-    for(u32 x = 0; x < CHUNK_X; ++x) {
-        for(u32 y = 0; y < CHUNK_Y; ++y) {
-            for(u32 z = 0; z < CHUNK_Z; ++z) {
-                Voxel *voxel = get_chunk_voxel(chunk, x, y, z);
-                if(voxel->type == VOXEL_AIR && y < 49) {
-                    voxel->type = VOXEL_WATER;
-                }
+static void chunk_section_unpack(ChunkSection *section, Voxel *voxels) {
+    if(section->type != CHUNK_SECTION_MIXED) {
+        memset(voxels, section->palette[0].type, CHUNK_SECTION_SIZE * sizeof(Voxel));
+        return;
+    }
 
-                if(voxel->type != VOXEL_DIRT)
-                    continue;
-                Voxel *up = get_chunk_voxel(chunk, x, y + 1, z);
-                if(up && up->type == VOXEL_AIR) {
-                    voxel->type = VOXEL_GRASS;
-                }
-            }
+    u32 bits     = section->bits;
+    u32 mask     = (1u << bits) - 1;
+    u32 per_word = 32 / bits;
+    u32 words    = chunk_section_words(bits);
+    for(u32 word_index = 0; word_index < words; ++word_index) {
+        Voxel *dst = voxels + word_index * per_word;
+        u32 word   = section->data[word_index];
+        for(u32 i = 0; i < per_word; ++i) {
+            dst[i] = section->palette[word & mask];
+            word >>= bits;
         }
     }
 }
 
-static inline bool back_voxels_solid(Chunk *chunk, s32 x, s32 y, s32 z) {
+void chunk_initialize(Chunk *chunk) {
+    memset(chunk, 0, sizeof(*chunk));
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        chunk_section_set_uniform(chunk->sections + section, (Voxel){ VOXEL_AIR });
+    }
+    chunk->min_y = CHUNK_Y;
+}
+
+void chunk_release(Chunk *chunk) {
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        chunk_section_set_uniform(chunk->sections + section, (Voxel){ VOXEL_AIR });
+    }
+    chunk->min_y = CHUNK_Y;
+    chunk->max_y = 0;
+
+    chunk_release_geometry(chunk);
+}
+
+void chunk_release_geometry(Chunk *chunk) {
+    if(chunk->geometry != chunk->staging) {
+        mesh_free(chunk->geometry);
+    }
+    chunk->geometry          = NULL;
+    chunk->geometry_capacity = 0;
+    chunk->staged_count      = 0;
+}
+
+void chunk_pack_voxels(Chunk *chunk, Voxel *voxels) {
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        chunk_section_pack(chunk->sections + section, voxels + section * CHUNK_SECTION_SIZE);
+    }
+}
+
+void chunk_unpack_voxels(Chunk *chunk, Voxel *voxels) {
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        chunk_section_unpack(chunk->sections + section, voxels + section * CHUNK_SECTION_SIZE);
+    }
+}
+
+Voxel chunk_get_voxel(Chunk *chunk, u32 x, u32 y, u32 z) {
+    assert(x < CHUNK_X && y < CHUNK_Y && z < CHUNK_Z);
+    ChunkSection *section = chunk->sections + (y / CHUNK_SECTION_DIM);
+
+    if(section->type != CHUNK_SECTION_MIXED) {
+        return section->palette[0];
+    }
+
+    u32 bit   = (get_voxel_index(x, y, z) % CHUNK_SECTION_SIZE) * section->bits;
+    u32 index = (section->data[bit >> 5] >> (bit & 31)) & ((1u << section->bits) - 1);
+    return section->palette[index];
+}
+
+void chunk_set_voxel(Chunk *chunk, u32 x, u32 y, u32 z, Voxel voxel) {
+    assert(x < CHUNK_X && y < CHUNK_Y && z < CHUNK_Z);
+    ChunkSection *section = chunk->sections + (y / CHUNK_SECTION_DIM);
+    u32 voxel_index       = get_voxel_index(x, y, z) % CHUNK_SECTION_SIZE;
+
+    // NOTE: The bounds only grow, removing voxels leaves them conservative
+    if(voxel.type != VOXEL_AIR) {
+        chunk_extend_bounds(chunk, y, y);
+    }
+
+    u32 index = 0;
+    while(index < section->palette_count && section->palette[index].type != voxel.type) {
+        ++index;
+    }
 
-    if(z == 0) {
-        // if(chunk_is_loaded(chunk->x, chunk->z - 1)) {
-        f32 h = calculate_xz_height(chunk->x, chunk->z - 1, x, (CHUNK_Z - 1));
-        if(y < h) {
-            return true;
+    if(index == section->palette_count) {
+        // NOTE: New type, repack when the indices do not fit in the current bits anymore
+        if(chunk_section_bits(section->palette_count + 1) != section->bits) {
+            Voxel voxels[CHUNK_SECTION_SIZE];
+            chunk_section_unpack(section, voxels);
+            voxels[voxel_index] = voxel;
+            chunk_section_pack(section, voxels);
+            return;
         }
-        //}
+        section->palette[section->palette_count++] = voxel;
     }
 
-    Voxel *other = get_chunk_voxel(chunk, x, y, z - 1);
+    if(section->type != CHUNK_SECTION_MIXED) {
+        return;
+    }
 
-    if(!other) {
-        return false;
+    u32 bit  = voxel_index * section->bits;
+    u32 mask = ((1u << section->bits) - 1) << (bit & 31);
+    section->data[bit >> 5] = (section->data[bit >> 5] & ~mask) | (index << (bit & 31));
+}
+
+u32 chunk_get_voxels_size(Chunk *chunk) {
+    u32 result = sizeof(chunk->sections);
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        result += chunk_section_words(chunk->sections[section].bits) * sizeof(u32);
+    }
+    return result;
+}
+
+void chunk_get_section_stats(Chunk *chunk, ChunkSectionStats *stats) {
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        ChunkSection *chunk_section = chunk->sections + section;
+        stats->type_count[chunk_section->type] += 1;
+        if(chunk_section->type == CHUNK_SECTION_MIXED) {
+            stats->bits_count[chunk_section->bits] += 1;
+        }
     }
-    return other->type != VOXEL_AIR;
 }
 
-static inline bool front_voxels_solid(Chunk *chunk, s32 x, s32 y, s32 z) {
+// ----------------------------------------------------------------------
+
+static inline f32 calculate_height(f32 noise) {
+    f32 h = 20 + ((noise + 1) / 2.0f) * (u32)((CHUNK_Y / 2) - 50);
+    assert(h >= 0 && h < CHUNK_Y);
+    return h;
+}
+
+// NOTE: x and z go from -1 to CHUNK_X and CHUNK_Z, the apron columns belong to the neighbors
+static inline f32 get_chunk_height(Chunk *chunk, s32 x, s32 z) {
+    assert(x >= -1 && x <= CHUNK_X && z >= -1 && z <= CHUNK_Z);
+    return chunk->heightmap[(z + 1) * CHUNK_HEIGHTMAP_X + (x + 1)];
+}
 
-    if(z == (CHUNK_Z - 1)) {
-        // if(chunk_is_loaded(chunk->x, chunk->z + 1)) {
-        f32 h = calculate_xz_height(chunk->x, chunk->z + 1, x, 0);
-        if(y < h) {
-            return true;
+// NOTE: The noise of every column (apron included) is evaluated in a single batch
+static void chunk_generate_heightmap(Chunk *chunk) {
+    f32 noise_x[CHUNK_HEIGHTMAP_SIZE];
+    f32 noise_y[CHUNK_HEIGHTMAP_SIZE];
+    f32 noise_z[CHUNK_HEIGHTMAP_SIZE];
+
+    // NOTE: stb only takes an 8 bit seed, the whole world seed moves the sampled noise instead
+    u32 seed_hash = random_mix((u32)world_seed);
+    f32 offset_x  = (f32)(seed_hash & 0xff);
+    f32 offset_y  = (f32)((seed_hash >> 8) & 0xffff) / 256.0f;
+    f32 offset_z  = (f32)(seed_hash >> 24);
+
+    for(s32 z = -1; z <= CHUNK_Z; ++z) {
+        for(s32 x = -1; x <= CHUNK_X; ++x) {
+            u32 index      = (z + 1) * CHUNK_HEIGHTMAP_X + (x + 1);
+            noise_x[index] = (chunk->x * CHUNK_X + x) / ((f32)CHUNK_X * 2.0f) + offset_x;
+            noise_y[index] = offset_y;
+            noise_z[index] = (chunk->z * CHUNK_Z + z) / ((f32)CHUNK_Z * 2.0f) + offset_z;
         }
-        //}
     }
 
-    Voxel *other = get_chunk_voxel(chunk, x, y, z + 1);
+    noise_perlin3_batch(chunk->heightmap, noise_x, noise_y, noise_z, CHUNK_HEIGHTMAP_SIZE, 0);
 
-    if(!other) {
-        return false;
+    for(u32 i = 0; i < CHUNK_HEIGHTMAP_SIZE; ++i) {
+        chunk->heightmap[i] = calculate_height(chunk->heightmap[i]);
     }
+}
 
-    return other->type != VOXEL_AIR;
+#define WATER_LEVEL 49
+
+// NOTE: Voxel type of a column of height h before water and grass are placed
+static inline u8 get_terrain_voxel_type(f32 h, s32 y) {
+    if(y <= h && y < 50) {
+        return VOXEL_STONE;
+    } else if(y < h) {
+        return VOXEL_DIRT;
+    }
+    return VOXEL_AIR;
 }
 
-static inline bool left_voxels_solid(Chunk *chunk, s32 x, s32 y, s32 z) {
+void chunk_generate_voxels(Chunk *chunk) {
+    if(!chunk) {
+        return;
+    }
 
-    if(x == 0) {
+    chunk_generate_heightmap(chunk);
+    if(job_is_cancelled(&chunk->job_handle)) {
+        return;
+    }
 
-        // if(chunk_is_loaded(chunk->x - 1, chunk->z)) {
-        f32 h = calculate_xz_height(chunk->x - 1, chunk->z, (CHUNK_X - 1), z);
-        if(y < h) {
-            return true;
+    f32 max_height = 0;
+    for(s32 z = 0; z < CHUNK_Z; ++z) {
+        for(s32 x = 0; x < CHUNK_X; ++x) {
+            f32 h = get_chunk_height(chunk, x, z);
+            if(h > max_height)
+                max_height = h;
         }
-        //}
     }
 
-    Voxel *other = get_chunk_voxel(chunk, x - 1, y, z);
+    // NOTE: Generate one section at a time and pack it
+    Voxel voxels[CHUNK_SECTION_SIZE];
 
-    if(!other) {
-        return false;
+    chunk->min_y = CHUNK_Y;
+    chunk->max_y = 0;
+
+    for(s32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        if(job_is_cancelled(&chunk->job_handle)) {
+            return;
+        }
+
+        s32 min_y = section * CHUNK_SECTION_DIM;
+        s32 max_y = min_y + CHUNK_SECTION_DIM - 1;
+
+        // NOTE: Sections above the terrain are all air or all water, skip them
+        if(min_y > max_height) {
+            if(min_y >= WATER_LEVEL) {
+                chunk_section_set_uniform(chunk->sections + section, (Voxel){ VOXEL_AIR });
+                continue;
+            }
+            if(max_y < WATER_LEVEL) {
+                chunk_section_set_uniform(chunk->sections + section, (Voxel){ VOXEL_WATER });
+                chunk_extend_bounds(chunk, min_y, max_y);
+                continue;
+            }
+        }
+
+        for(s32 y = min_y; y <= max_y; ++y) {
+            for(s32 z = 0; z < CHUNK_Z; ++z) {
+                for(s32 x = 0; x < CHUNK_X; ++x) {
+
+                    f32 h   = get_chunk_height(chunk, x, z);
+                    u8 type = get_terrain_voxel_type(h, y);
+
+                    if(type == VOXEL_STONE) {
+                        s32 world_x = chunk->x * CHUNK_X + x;
+                        s32 world_z = chunk->z * CHUNK_Z + z;
+
+                        s32 num = random_range(world_x, y, world_z, 0, 0, 100);
+                        if(num < 6) {
+                            type = random_range(world_x, y, world_z, 1, VOXEL_BLOCK_MINERAL_BLUE,
+                                          VOXEL_BLOCK_MINERAL_RED + 1);
+                        }
+                    } else if(type == VOXEL_AIR && y < WATER_LEVEL) {
+                        type = VOXEL_WATER;
+                    } else if(type == VOXEL_DIRT && (y + 1) < CHUNK_Y &&
+                              get_terrain_voxel_type(h, y + 1) == VOXEL_AIR) {
+                        type = VOXEL_GRASS;
+                    }
+
+                    voxels[get_voxel_index(x, y, z) % CHUNK_SECTION_SIZE].type = type;
+                    if(type != VOXEL_AIR) {
+                        chunk_extend_bounds(chunk, y, y);
+                    }
+                }
+            }
+        }
+
+        chunk_section_pack(chunk->sections + section, voxels);
     }
-    return other->type != VOXEL_AIR;
 }
 
-static inline bool right_voxels_solid(Chunk *chunk, s32 x, s32 y, s32 z) {
+// NOTE: Corners of every face as (x | y << 1 | z << 2) bits, 0 selects the box min and 1 the
+// box max, in the same winding the faces always had
+static u8 face_corners[VOXEL_BLOCK_FACE_COUNT][6] = {
+    [VOXEL_BLOCK_BACK]   = { 0, 2, 3, 3, 1, 0 },
+    [VOXEL_BLOCK_FRONT]  = { 4, 7, 6, 7, 4, 5 },
+    [VOXEL_BLOCK_RIGHT]  = { 1, 3, 5, 5, 3, 7 },
+    [VOXEL_BLOCK_LEFT]   = { 0, 4, 2, 4, 6, 2 },
+    [VOXEL_BLOCK_TOP]    = { 2, 6, 7, 7, 3, 2 },
+    [VOXEL_BLOCK_BOTTOM] = { 0, 5, 4, 5, 0, 1 },
+};
+
+// NOTE: Emit the face of the box [min, max] (in voxels), normals and texture coordinates are
+// computed in the shader from the face and the position so the tile repeats once per voxel across
+// merged faces
+static inline void add_face(Chunk *chunk, VoxelBlockFace face, u8 tile, s32 min_x, s32 min_y,
+                            s32 min_z, s32 max_x, s32 max_y, s32 max_z) {
+    u32 x[2] = { (u32)min_x, (u32)max_x };
+    u32 y[2] = { (u32)min_y, (u32)max_y };
+    u32 z[2] = { (u32)min_z, (u32)max_z };
+
+    for(u32 i = 0; i < 6; ++i) {
+        u8 corner = face_corners[face][i];
+        add_vertex(chunk, vertex_pack(x[corner & 1], y[(corner >> 1) & 1], z[(corner >> 2) & 1],
+                                      face, tile));
+    }
+}
+
+// NOTE: Meshing input, the voxels of the chunk plus a one voxel border with the voxels of the
+// neighbor chunks (or the predicted terrain if a neighbor is not available) and an air layer
+// above and below, so the meshers can look at the neighbor of any voxel without bounds checks
+#define PADDED_X (CHUNK_X + 2)
+#define PADDED_Y (CHUNK_Y + 2)
+#define PADDED_Z (CHUNK_Z + 2)
+#define PADDED_SIZE (PADDED_X * PADDED_Y * PADDED_Z)
 
-    if(x == CHUNK_X - 1) {
-        // if(chunk_is_loaded(chunk->x + 1, chunk->z)) {
-        f32 h = calculate_xz_height(chunk->x + 1, chunk->z, 0, z);
-        if(y < h) {
-            return true;
+static inline u32 get_padded_index(s32 x, s32 y, s32 z) {
+    return (y + 1) * (PADDED_X * PADDED_Z) + (z + 1) * PADDED_X + (x + 1);
+}
+
+// NOTE: Offset from a voxel to the voxel in front of each of its faces
+static s32 face_padded_offsets[VOXEL_BLOCK_FACE_COUNT] = {
+    [VOXEL_BLOCK_BACK] = -PADDED_X,
+    [VOXEL_BLOCK_FRONT] = PADDED_X,
+    [VOXEL_BLOCK_RIGHT] = 1,
+    [VOXEL_BLOCK_LEFT] = -1,
+    [VOXEL_BLOCK_TOP] = PADDED_X * PADDED_Z,
+    [VOXEL_BLOCK_BOTTOM] = -(PADDED_X * PADDED_Z),
+};
+
+// NOTE: Fill a column of the border, from the neighbor when it is available or from the predicted
+// terrain height. Any solid type works for the prediction, the meshers only ask for air
+static inline void chunk_fill_border_column(Chunk *chunk, Chunk *neighbor, Voxel *padded, s32 x,
+                                            s32 z, s32 min_y, s32 max_y) {
+    if(neighbor) {
+        u32 neighbor_x = (u32)((x + CHUNK_X) % CHUNK_X);
+        u32 neighbor_z = (u32)((z + CHUNK_Z) % CHUNK_Z);
+        for(s32 y = min_y; y < max_y; ++y) {
+            padded[get_padded_index(x, y, z)] = chunk_get_voxel(neighbor, neighbor_x, (u32)y, neighbor_z);
+        }
+    } else {
+        f32 height = get_chunk_height(chunk, x, z);
+        for(s32 y = min_y; y < max_y && (f32)y < height; ++y) {
+            padded[get_padded_index(x, y, z)].type = VOXEL_STONE;
         }
-        //}
     }
+}
 
-    Voxel *other = get_chunk_voxel(chunk, x + 1, y, z);
+static void chunk_build_padded_voxels(Chunk *chunk, Chunk **neighbors, Voxel *padded) {
+    // NOTE: Only the layers up to the air layer above the highest non empty section are read by
+    // the meshers, the rest of the buffer is left uninitialized
+    u32 top_section = CHUNK_SECTION_COUNT;
+    while(top_section > 0 && chunk->sections[top_section - 1].type == CHUNK_SECTION_EMPTY) {
+        --top_section;
+    }
+    static_assert(VOXEL_AIR == 0, "the padded voxels are cleared to air with memset");
+    memset(padded, 0, sizeof(Voxel) * get_padded_index(-1, top_section * CHUNK_SECTION_DIM + 1, -1));
+
+    Chunk *back  = neighbors ? neighbors[CHUNK_NEIGHBOR_BACK] : NULL;
+    Chunk *front = neighbors ? neighbors[CHUNK_NEIGHBOR_FRONT] : NULL;
+    Chunk *left  = neighbors ? neighbors[CHUNK_NEIGHBOR_LEFT] : NULL;
+    Chunk *right = neighbors ? neighbors[CHUNK_NEIGHBOR_RIGHT] : NULL;
+
+    Voxel section_voxels[CHUNK_SECTION_SIZE];
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        // NOTE: Nothing is meshed in empty sections, their border is never looked at
+        if(chunk->sections[section].type == CHUNK_SECTION_EMPTY) {
+            continue;
+        }
+        chunk_section_unpack(chunk->sections + section, section_voxels);
+
+        s32 min_y = section * CHUNK_SECTION_DIM;
+        s32 max_y = min_y + CHUNK_SECTION_DIM;
+        for(s32 y = min_y; y < max_y; ++y) {
+            for(s32 z = 0; z < CHUNK_Z; ++z) {
+                memcpy(padded + get_padded_index(0, y, z),
+                       section_voxels + get_voxel_index(0, y, z) % CHUNK_SECTION_SIZE,
+                       sizeof(Voxel) * CHUNK_X);
+            }
+        }
 
-    if(!other) {
-        return false;
+        for(s32 i = 0; i < CHUNK_X; ++i) {
+            chunk_fill_border_column(chunk, back, padded, i, -1, min_y, max_y);
+            chunk_fill_border_column(chunk, front, padded, i, CHUNK_Z, min_y, max_y);
+        }
+        for(s32 i = 0; i < CHUNK_Z; ++i) {
+            chunk_fill_border_column(chunk, left, padded, -1, i, min_y, max_y);
+            chunk_fill_border_column(chunk, right, padded, CHUNK_X, i, min_y, max_y);
+        }
     }
-    return other->type != VOXEL_AIR;
 }
 
-static inline bool top_voxels_solid(Chunk *chunk, s32 x, s32 y, s32 z) {
-    Voxel *other = get_chunk_voxel(chunk, x, y + 1, z);
-    if(!other) {
+static inline b32 face_voxels_solid(Voxel *voxel, VoxelBlockFace face) {
+    return voxel[face_padded_offsets[face]].type != VOXEL_AIR;
+}
+
+// NOTE: Sections without air, the palette holds every voxel type of the section
+static b32 chunk_section_is_solid(ChunkSection *section) {
+    if(section->type == CHUNK_SECTION_EMPTY) {
         return false;
     }
-    return other->type != VOXEL_AIR;
+    for(u32 i = 0; i < section->palette_count; ++i) {
+        if(section->palette[i].type == VOXEL_AIR) {
+            return false;
+        }
+    }
+    return true;
 }
 
-static inline bool bottom_voxels_solid(Chunk *chunk, s32 x, s32 y, s32 z) {
-    Voxel *other = get_chunk_voxel(chunk, x, y - 1, z);
-    if(!other) {
+// NOTE: Sections that cannot have visible faces, empty ones and solid ones enclosed by solid
+// voxels on every side. The stone below the surface is mixed with ores, so the palette is checked
+// instead of asking for uniform sections
+static b32 chunk_section_is_hidden(Chunk *chunk, Voxel *padded, s32 section) {
+    ChunkSection *sections = chunk->sections;
+
+    if(sections[section].type == CHUNK_SECTION_EMPTY) {
+        return true;
+    }
+    if(!chunk_section_is_solid(sections + section)) {
         return false;
     }
-    return other->type != VOXEL_AIR;
-}
 
-void chunk_generate_geometry(Chunk *chunk) {
-    if(!chunk) {
-        return;
+    // NOTE: The air layers of the padded voxels keep the bottom and top sections visible
+    s32 min_y = section * CHUNK_SECTION_DIM;
+    s32 max_y = min_y + CHUNK_SECTION_DIM - 1;
+    for(s32 z = 0; z < CHUNK_Z; ++z) {
+        for(s32 x = 0; x < CHUNK_X; ++x) {
+            if(padded[get_padded_index(x, min_y - 1, z)].type == VOXEL_AIR ||
+               padded[get_padded_index(x, max_y + 1, z)].type == VOXEL_AIR) {
+                return false;
+            }
+        }
+    }
+    for(s32 y = min_y; y <= max_y; ++y) {
+        for(s32 i = 0; i < CHUNK_X; ++i) {
+            if(padded[get_padded_index(i, y, -1)].type == VOXEL_AIR ||
+               padded[get_padded_index(i, y, CHUNK_Z)].type == VOXEL_AIR ||
+               padded[get_padded_index(-1, y, i)].type == VOXEL_AIR ||
+               padded[get_padded_index(CHUNK_X, y, i)].type == VOXEL_AIR) {
+                return false;
+            }
+        }
     }
 
-    chunk->geometry_count = 0;
+    return true;
+}
 
-    for(u32 x = 0; x < CHUNK_X; ++x) {
-        for(u32 y = 0; y < CHUNK_Y; ++y) {
+static void chunk_generate_geometry_naive(Chunk *chunk, Voxel *padded) {
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        if(chunk_section_is_hidden(chunk, padded, section)) {
+            continue;
+        }
+
+        u32 min_y = section * CHUNK_SECTION_DIM;
+        for(u32 y = min_y; y < min_y + CHUNK_SECTION_DIM; ++y) {
             for(u32 z = 0; z < CHUNK_Z; ++z) {
+                for(u32 x = 0; x < CHUNK_X; ++x) {
 
-                Voxel *voxel = get_chunk_voxel(chunk, x, y, z);
-                if(voxel->type == VOXEL_AIR)
-                    continue;
+                    Voxel *voxel = padded + get_padded_index(x, y, z);
+                    if(voxel->type == VOXEL_AIR)
+                        continue;
 
-                f32 min_x = x * VOXEL_DIM - VOXEL_DIM * 0.5f;
-                f32 max_x = min_x + VOXEL_DIM;
-                f32 min_y = y * VOXEL_DIM - VOXEL_DIM * 0.5f;
-                f32 max_y = min_y + VOXEL_DIM;
-                f32 min_z = z * VOXEL_DIM - VOXEL_DIM * 0.5f;
-                f32 max_z = min_z + VOXEL_DIM;
-
-                VoxelBlock block_coords = voxel_block_map[voxel->type];
-
-                if(!back_voxels_solid(chunk, x, y, z)) {
-                    R2 coords = block_coords.coords[VOXEL_BLOCK_BACK];
-                    // NOTE: Back face
-                    add_vertex(chunk, v3(min_x, min_y, min_z), v3(0, 0, -1), coords.min);
-                    add_vertex(chunk, v3(min_x, max_y, min_z), v3(0, 0, -1),
-                               v2(coords.min.x, coords.max.y));
-                    add_vertex(chunk, v3(max_x, max_y, min_z), v3(0, 0, -1), coords.max);
-                    add_vertex(chunk, v3(max_x, max_y, min_z), v3(0, 0, -1), coords.max);
-                    add_vertex(chunk, v3(max_x, min_y, min_z), v3(0, 0, -1),
-                               v2(coords.max.x, coords.min.y));
-                    add_vertex(chunk, v3(min_x, min_y, min_z), v3(0, 0, -1), coords.min);
+                    VoxelBlock block = voxel_block_map[voxel->type];
+
+                    for(u32 face = 0; face < VOXEL_BLOCK_FACE_COUNT; ++face) {
+                        if(!face_voxels_solid(voxel, face)) {
+                            add_face(chunk, face, block.tiles[face], x, y, z, x + 1, y + 1,
+                                     z + 1);
+                        }
+                    }
                 }
+            }
+        }
+    }
+}
+
+// NOTE: Every face is meshed as slices along its normal axis, each slice is a u * v mask of
+// (voxel type, tile) keys that get merged into the biggest rectangles possible
+typedef struct GreedyAxes {
+    u32 n, u, v;
+} GreedyAxes;
+
+static GreedyAxes greedy_axes[VOXEL_BLOCK_FACE_COUNT] = {
+    [VOXEL_BLOCK_BACK] = { 2, 0, 1 }, [VOXEL_BLOCK_FRONT] = { 2, 0, 1 },
+    [VOXEL_BLOCK_RIGHT] = { 0, 2, 1 }, [VOXEL_BLOCK_LEFT] = { 0, 2, 1 },
+    [VOXEL_BLOCK_TOP] = { 1, 0, 2 },   [VOXEL_BLOCK_BOTTOM] = { 1, 0, 2 },
+};
+
+static s32 chunk_dims[3] = { CHUNK_X, CHUNK_Y, CHUNK_Z };
+
+#define GREEDY_MASK_SIZE (CHUNK_Y * CHUNK_Z)
+
+static void chunk_generate_geometry_greedy(Chunk *chunk, Voxel *padded) {
+    // NOTE: Resolve face visibility once per voxel, the slices below only read it back
+    u8 visible_faces[CHUNK_TOTAL_SIZE];
+    s32 faces_min_y[VOXEL_BLOCK_FACE_COUNT];
+    s32 faces_max_y[VOXEL_BLOCK_FACE_COUNT];
+    for(u32 face = 0; face < VOXEL_BLOCK_FACE_COUNT; ++face) {
+        faces_min_y[face] = CHUNK_Y;
+        faces_max_y[face] = -1;
+    }
+
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        if(chunk_section_is_hidden(chunk, padded, section)) {
+            memset(visible_faces + section * CHUNK_SECTION_SIZE, 0, CHUNK_SECTION_SIZE);
+            continue;
+        }
 
-                if(!front_voxels_solid(chunk, x, y, z)) {
-                    R2 coords = block_coords.coords[VOXEL_BLOCK_FRONT];
-                    // NOTE: Front face
-                    add_vertex(chunk, v3(min_x, min_y, max_z), v3(0, 0, 1), coords.min);
-                    add_vertex(chunk, v3(max_x, max_y, max_z), v3(0, 0, 1), coords.max);
-                    add_vertex(chunk, v3(min_x, max_y, max_z), v3(0, 0, 1),
-                               v2(coords.min.x, coords.max.y));
-                    add_vertex(chunk, v3(max_x, max_y, max_z), v3(0, 0, 1), coords.max);
-                    add_vertex(chunk, v3(min_x, min_y, max_z), v3(0, 0, 1), coords.min);
-                    add_vertex(chunk, v3(max_x, min_y, max_z), v3(0, 0, 1),
-                               v2(coords.max.x, coords.min.y));
+        u32 min_y = section * CHUNK_SECTION_DIM;
+        for(u32 y = min_y; y < min_y + CHUNK_SECTION_DIM; ++y) {
+            for(u32 z = 0; z < CHUNK_Z; ++z) {
+                for(u32 x = 0; x < CHUNK_X; ++x) {
+                    Voxel *voxel = padded + get_padded_index(x, y, z);
+                    u8 faces     = 0;
+                    if(voxel->type != VOXEL_AIR) {
+                        for(u32 face = 0; face < VOXEL_BLOCK_FACE_COUNT; ++face) {
+                            if(!face_voxels_solid(voxel, face)) {
+                                faces |= (u8)(1 << face);
+                                if((s32)y < faces_min_y[face])
+                                    faces_min_y[face] = y;
+                                if((s32)y > faces_max_y[face])
+                                    faces_max_y[face] = y;
+                            }
+                        }
+                    }
+                    visible_faces[get_voxel_index(x, y, z)] = faces;
                 }
+            }
+        }
+    }
 
-                if(!right_voxels_solid(chunk, x, y, z)) {
-                    R2 coords = block_coords.coords[VOXEL_BLOCK_RIGHT];
-                    // NOTE: Right face
-                    add_vertex(chunk, v3(max_x, min_y, min_z), v3(1, 0, 0),
-                               v2(coords.max.x, coords.min.y));
-                    add_vertex(chunk, v3(max_x, max_y, min_z), v3(1, 0, 0),
-                               v2(coords.max.x, coords.max.y));
-                    add_vertex(chunk, v3(max_x, min_y, max_z), v3(1, 0, 0),
-                               v2(coords.min.x, coords.min.y));
-                    add_vertex(chunk, v3(max_x, min_y, max_z), v3(1, 0, 0),
-                               v2(coords.min.x, coords.min.y));
-                    add_vertex(chunk, v3(max_x, max_y, min_z), v3(1, 0, 0),
-                               v2(coords.max.x, coords.max.y));
-                    add_vertex(chunk, v3(max_x, max_y, max_z), v3(1, 0, 0),
-                               v2(coords.min.x, coords.max.y));
+    u16 mask[GREEDY_MASK_SIZE];
+
+    for(u32 face = 0; face < VOXEL_BLOCK_FACE_COUNT; ++face) {
+        GreedyAxes axes = greedy_axes[face];
+        s32 size_u      = chunk_dims[axes.u];
+        assert(size_u * chunk_dims[axes.v] <= GREEDY_MASK_SIZE);
+
+        // NOTE: Only walk the layers that have a visible face of this kind
+        s32 min[3] = { 0, faces_min_y[face], 0 };
+        s32 max[3] = { CHUNK_X, faces_max_y[face] + 1, CHUNK_Z };
+        s32 min_v  = min[axes.v];
+        s32 max_v  = max[axes.v];
+
+        for(s32 n = min[axes.n]; n < max[axes.n]; ++n) {
+
+            // NOTE: Build the mask of visible faces for this slice
+            s32 pos[3];
+            pos[axes.n] = n;
+            for(s32 v = min_v; v < max_v; ++v) {
+                for(s32 u = 0; u < size_u; ++u) {
+                    pos[axes.u] = u;
+                    pos[axes.v] = v;
+
+                    u16 key      = 0;
+                    Voxel *voxel = padded + get_padded_index(pos[0], pos[1], pos[2]);
+                    if(visible_faces[get_voxel_index(pos[0], pos[1], pos[2])] & (1 << face)) {
+                        u8 tile = voxel_block_map[voxel->type].tiles[face];
+                        key     = (u16)(((voxel->type << 8) | tile) + 1);
+                    }
+                    mask[v * size_u + u] = key;
                 }
+            }
+
+            // NOTE: Merge the mask into rectangles
+            for(s32 v = min_v; v < max_v; ++v) {
+                for(s32 u = 0; u < size_u;) {
+                    u16 key = mask[v * size_u + u];
+                    if(!key) {
+                        ++u;
+                        continue;
+                    }
+
+                    s32 w = 1;
+                    while(u + w < size_u && mask[v * size_u + u + w] == key) {
+                        ++w;
+                    }
 
-                if(!left_voxels_solid(chunk, x, y, z)) {
-                    R2 coords = block_coords.coords[VOXEL_BLOCK_LEFT];
-                    // NOTE: Left face
-                    add_vertex(chunk, v3(min_x, min_y, min_z), v3(-1, 0, 0),
-                               v2(coords.min.x, coords.min.y));
-                    add_vertex(chunk, v3(min_x, min_y, max_z), v3(-1, 0, 0),
-                               v2(coords.max.x, coords.min.y));
-                    add_vertex(chunk, v3(min_x, max_y, min_z), v3(-1, 0, 0),
-                               v2(coords.min.x, coords.max.y));
-                    add_vertex(chunk, v3(min_x, min_y, max_z), v3(-1, 0, 0),
-                               v2(coords.max.x, coords.min.y));
-                    add_vertex(chunk, v3(min_x, max_y, max_z), v3(-1, 0, 0),
-                               v2(coords.max.x, coords.max.y));
-                    add_vertex(chunk, v3(min_x, max_y, min_z), v3(-1, 0, 0),
-                               v2(coords.min.x, coords.max.y));
+                    s32 h = 1;
+                    for(; v + h < max_v; ++h) {
+                        u16 *row = mask + (v + h) * size_u + u;
+                        s32 k    = 0;
+                        while(k < w && row[k] == key) {
+                            ++k;
+                        }
+                        if(k < w)
+                            break;
+                    }
+
+                    for(s32 hh = 0; hh < h; ++hh) {
+                        memset(mask + (v + hh) * size_u + u, 0, sizeof(u16) * w);
+                    }
+
+                    s32 quad_min[3], quad_max[3];
+                    quad_min[axes.n] = n;
+                    quad_max[axes.n] = n + 1;
+                    quad_min[axes.u] = u;
+                    quad_max[axes.u] = u + w;
+                    quad_min[axes.v] = v;
+                    quad_max[axes.v] = v + h;
+
+                    u8 tile = (u8)((key - 1) & 0xff);
+                    add_face(chunk, face, tile, quad_min[0], quad_min[1], quad_min[2], quad_max[0],
+                             quad_max[1], quad_max[2]);
+
+                    u += w;
                 }
+            }
+        }
+    }
+}
+
+// NOTE: Solid voxels of every (y, z) row packed as bits along x. Bit x + 1 is the voxel x of the
+// chunk, bits 0 and CHUNK_X + 1 are the border voxels of the left and right neighbors and rows
+// 0 and CHUNK_Z + 1 are the rows of the back and front neighbors. A face is visible where its
+// voxel bit is set and the bit of the voxel in front of it is not, so every row gets all its
+// faces with a few shifts
+#define BITMASK_ROW_BITS (((1u << CHUNK_X) - 1) << 1)
+
+static inline u32 bitmask_lowest_bit(u32 bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (u32)index;
+#else
+    return (u32)__builtin_ctz(bits);
+#endif
+}
 
-                if(!top_voxels_solid(chunk, x, y, z)) {
-                    R2 coords = block_coords.coords[VOXEL_BLOCK_TOP];
-                    // NOTE: Top face
-                    add_vertex(chunk, v3(min_x, max_y, min_z), v3(0, 1, 0),
-                               v2(coords.min.x, coords.max.y));
-                    add_vertex(chunk, v3(min_x, max_y, max_z), v3(0, 1, 0),
-                               v2(coords.min.x, coords.min.y));
-                    add_vertex(chunk, v3(max_x, max_y, max_z), v3(0, 1, 0),
-                               v2(coords.max.x, coords.min.y));
-                    add_vertex(chunk, v3(max_x, max_y, max_z), v3(0, 1, 0),
-                               v2(coords.max.x, coords.min.y));
-                    add_vertex(chunk, v3(max_x, max_y, min_z), v3(0, 1, 0),
-                               v2(coords.max.x, coords.max.y));
-                    add_vertex(chunk, v3(min_x, max_y, min_z), v3(0, 1, 0),
-                               v2(coords.min.x, coords.max.y));
+static void chunk_generate_geometry_bitmask(Chunk *chunk, Voxel *padded) {
+    static_assert(PADDED_X <= 32, "the rows of the bitmask mesher do not fit in 32 bits");
+
+    u32 occupancy[CHUNK_Y][PADDED_Z];
+
+    for(s32 y = 0; y < CHUNK_Y; ++y) {
+        if(chunk->sections[y / CHUNK_SECTION_DIM].type == CHUNK_SECTION_EMPTY) {
+            memset(occupancy[y], 0, sizeof(occupancy[y]));
+            continue;
+        }
+        for(s32 z = -1; z <= CHUNK_Z; ++z) {
+            Voxel *voxel = padded + get_padded_index(-1, y, z);
+            u32 row      = 0;
+            for(s32 x = 0; x < PADDED_X; ++x) {
+                row |= (u32)(voxel[x].type != VOXEL_AIR) << x;
+            }
+            occupancy[y][z + 1] = row;
+        }
+    }
+
+    for(u32 section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        if(chunk_section_is_hidden(chunk, padded, section)) {
+            continue;
+        }
+
+        s32 min_y = section * CHUNK_SECTION_DIM;
+        for(s32 y = min_y; y < min_y + CHUNK_SECTION_DIM; ++y) {
+            for(s32 z = 0; z < CHUNK_Z; ++z) {
+                u32 row = occupancy[y][z + 1];
+                if(!(row & BITMASK_ROW_BITS)) {
+                    continue;
                 }
 
-                if(!bottom_voxels_solid(chunk, x, y, z)) {
-                    R2 coords = block_coords.coords[VOXEL_BLOCK_BOTTOM];
-                    // NOTE: Bottom face
-                    add_vertex(chunk, v3(min_x, min_y, min_z), v3(0, -1, 0),
-                               v2(coords.min.x, coords.max.y));
-                    add_vertex(chunk, v3(max_x, min_y, max_z), v3(0, -1, 0),
-                               v2(coords.max.x, coords.min.y));
-                    add_vertex(chunk, v3(min_x, min_y, max_z), v3(0, -1, 0),
-                               v2(coords.min.x, coords.min.y));
-                    add_vertex(chunk, v3(max_x, min_y, max_z), v3(0, -1, 0),
-                               v2(coords.max.x, coords.min.y));
-                    add_vertex(chunk, v3(min_x, min_y, min_z), v3(0, -1, 0),
-                               v2(coords.min.x, coords.max.y));
-                    add_vertex(chunk, v3(max_x, min_y, min_z), v3(0, -1, 0),
-                               v2(coords.max.x, coords.max.y));
+                u32 below = y > 0 ? occupancy[y - 1][z + 1] : 0;
+                u32 above = y < CHUNK_Y - 1 ? occupancy[y + 1][z + 1] : 0;
+
+                u32 faces[VOXEL_BLOCK_FACE_COUNT];
+                faces[VOXEL_BLOCK_BACK]   = row & ~occupancy[y][z];
+                faces[VOXEL_BLOCK_FRONT]  = row & ~occupancy[y][z + 2];
+                faces[VOXEL_BLOCK_RIGHT]  = row & ~(row >> 1);
+                faces[VOXEL_BLOCK_LEFT]   = row & ~(row << 1);
+                faces[VOXEL_BLOCK_TOP]    = row & ~above;
+                faces[VOXEL_BLOCK_BOTTOM] = row & ~below;
+
+                Voxel *voxel = padded + get_padded_index(0, y, z);
+                for(u32 face = 0; face < VOXEL_BLOCK_FACE_COUNT; ++face) {
+                    u32 bits = faces[face] & BITMASK_ROW_BITS;
+
+                    // NOTE: Faces along x merge into runs of the same voxel type, the x faces of a
+                    // row are never next to each other
+                    b32 merge = face != VOXEL_BLOCK_RIGHT && face != VOXEL_BLOCK_LEFT;
+                    while(bits) {
+                        u32 bit = bitmask_lowest_bit(bits);
+                        s32 x   = (s32)bit - 1;
+                        u8 type = voxel[x].type;
+
+                        s32 length = 1;
+                        while(merge && (bits & (1u << (bit + length))) &&
+                              voxel[x + length].type == type) {
+                            ++length;
+                        }
+                        bits &= ~(((1u << length) - 1) << bit);
+
+                        add_face(chunk, face, voxel_block_map[type].tiles[face], x, y, z, x + length,
+                                 y + 1, z + 1);
+                    }
                 }
             }
         }
     }
 }
+
+void chunk_generate_geometry(Chunk *chunk, Chunk **neighbors) {
+    if(!chunk) {
+        return;
+    }
+
+    chunk->geometry_count = 0;
+    chunk->staged_count   = 0;
+    if(chunk->staging && chunk->geometry != chunk->staging) {
+        chunk_release_geometry(chunk);
+        chunk->geometry          = chunk->staging;
+        chunk->geometry_capacity = chunk->staging_capacity;
+    }
+
+    // NOTE: Mesh from an unpacked copy of the voxels with the neighbor borders around it
+    Voxel padded[PADDED_SIZE];
+    chunk_build_padded_voxels(chunk, neighbors, padded);
+    if(job_is_cancelled(&chunk->job_handle)) {
+        return;
+    }
+
+    switch(chunk_mesher) {
+    case CHUNK_MESHER_NAIVE: {
+        chunk_generate_geometry_naive(chunk, padded);
+    } break;
+    case CHUNK_MESHER_GREEDY: {
+        chunk_generate_geometry_greedy(chunk, padded);
+    } break;
+    case CHUNK_MESHER_BITMASK: {
+        chunk_generate_geometry_bitmask(chunk, padded);
+    } break;
+    default: {
+        assert(!"invalid chunk mesher");
+    } break;
+    }
+}
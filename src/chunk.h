@@ -2,7 +2,9 @@
 #define _CHUNK_H_
 
 #include "gpu.h"
+#include "mesh.h"
 #include "voxel.h"
+#include "job.h"
 
 #define CHUNK_X 16
 #define CHUNK_Y 256
@@ -11,32 +13,170 @@
 
 #define MAX_CHUNKS_X (32 * 1)
 #define MAX_CHUNKS_Y (32 * 1)
-#define MAX_CHUNK_GEOMETRY_SIZE (1 * 1024 * 1024)
+// NOTE: A chunk mesh has to fit the largest block of the mesh pool
+#define MAX_CHUNK_VERTICES MESH_MAX_VERTICES
+
+typedef enum ChunkMesher {
+    CHUNK_MESHER_NAIVE,
+    CHUNK_MESHER_GREEDY,
+    CHUNK_MESHER_BITMASK,
+
+    CHUNK_MESHER_COUNT,
+} ChunkMesher;
+
+// NOTE: Neighbors handed to the mesher, their border voxels decide which faces at the chunk
+// borders are visible
+typedef enum ChunkNeighbor {
+    CHUNK_NEIGHBOR_BACK,  // NOTE: z - 1
+    CHUNK_NEIGHBOR_FRONT, // NOTE: z + 1
+    CHUNK_NEIGHBOR_LEFT,  // NOTE: x - 1
+    CHUNK_NEIGHBOR_RIGHT, // NOTE: x + 1
+
+    CHUNK_NEIGHBOR_COUNT,
+} ChunkNeighbor;
+
+// NOTE: Lifecycle of a chunk slot. The jobs move the chunk from queued to generating to generated
+// and from generated to meshing to meshed, the main thread does every other transition. The
+// state is stored next to a token that changes every time the slot is recycled, so a job only
+// moves the chunk it was pushed for
+typedef enum ChunkState {
+    CHUNK_STATE_FREE,       // NOTE: In the free list
+    CHUNK_STATE_QUEUED,     // NOTE: Generate job pushed
+    CHUNK_STATE_GENERATING,
+    CHUNK_STATE_GENERATED,  // NOTE: Voxels ready, waiting for the mesh job
+    CHUNK_STATE_MESHING,
+    CHUNK_STATE_MESHED,     // NOTE: Staging mesh ready, waiting for the upload
+    CHUNK_STATE_UPLOADED,
+    CHUNK_STATE_EVICTING,   // NOTE: Unloaded, waiting for its job and the meshes that read it
+
+    CHUNK_STATE_COUNT,
+} ChunkState;
+
+typedef enum ChunkJob {
+    CHUNK_JOB_NONE,
+    CHUNK_JOB_GENERATE,
+    CHUNK_JOB_MESH,
+} ChunkJob;
 
 typedef struct ChunkNode {
     struct ChunkNode *prev;
     struct ChunkNode *next;
-    struct ChunkNode *prev_hash;
-    struct ChunkNode *next_hash;
+    struct ChunkNode *prev_column;
+    struct ChunkNode *next_column;
+    struct ChunkNode *prev_row;
+    struct ChunkNode *next_row;
 } ChunkNode;
 
+// NOTE: Chunks are split in vertical sections of 16x16x16 voxels. Empty (all air) and uniform
+// sections only store their voxel, mixed sections store a palette and every cell an index into it
+// packed with the fewest bits that fit the palette (1, 2 or 4)
+#define CHUNK_SECTION_DIM 16
+#define CHUNK_SECTION_COUNT (CHUNK_Y / CHUNK_SECTION_DIM)
+#define CHUNK_SECTION_SIZE (CHUNK_X * CHUNK_SECTION_DIM * CHUNK_Z)
+
+typedef enum ChunkSectionType {
+    CHUNK_SECTION_EMPTY,
+    CHUNK_SECTION_UNIFORM,
+    CHUNK_SECTION_MIXED,
+
+    CHUNK_SECTION_TYPE_COUNT,
+} ChunkSectionType;
+
+typedef struct ChunkSection {
+    u8 type;
+    u8 palette_count;
+    u8 bits;
+    Voxel palette[VOXEL_TYPE_COUNT];
+    u32 *data;
+} ChunkSection;
+
+typedef struct ChunkSectionStats {
+    u32 type_count[CHUNK_SECTION_TYPE_COUNT];
+    u32 bits_count[5];
+} ChunkSectionStats;
+
+// NOTE: Terrain height of every column of the chunk plus a one column apron around it, so the
+// mesher can tell if the neighbor border voxels are solid without evaluating the noise again
+#define CHUNK_HEIGHTMAP_X (CHUNK_X + 2)
+#define CHUNK_HEIGHTMAP_Z (CHUNK_Z + 2)
+#define CHUNK_HEIGHTMAP_SIZE (CHUNK_HEIGHTMAP_X * CHUNK_HEIGHTMAP_Z)
+
 typedef struct Chunk {
 
     ChunkNode header;
 
     s32 x, z;
-    Voxel voxels[CHUNK_TOTAL_SIZE];
-    Vertex geometry[(MAX_CHUNK_GEOMETRY_SIZE / sizeof(Vertex))];
+    ChunkSection sections[CHUNK_SECTION_COUNT];
+    f32 heightmap[CHUNK_HEIGHTMAP_SIZE];
+    // NOTE: Lowest and highest non air voxel, min_y > max_y if the chunk is all air
+    u32 min_y, max_y;
+    // NOTE: Staging mesh, released once it is uploaded to the gpu. geometry_count counts the whole
+    // mesh, geometry holds the vertices from staged_count on
+    Vertex *geometry;
     u32 geometry_count;
+    u32 geometry_capacity;
+    // NOTE: Mapped gpu memory handed out before the mesh job, the mesh is written straight into it
+    // and continues in the mesh pool when it does not fit. The mapping is write only and the chunk
+    // never frees it
+    Vertex *staging;
+    u32 staging_capacity;
+    // NOTE: Vertices left in the full staging memory once the mesh moved on to the mesh pool
+    u32 staged_count;
+    // NOTE: Written in the slot bits of every vertex, see Vertex
+    u32 vertex_slot;
+
+    // NOTE: Range of the vertex arena with the mesh in the gpu, the staging mesh can be rebuilt
+    // while the chunk is drawn
+    u32 vertex_offset;
+    u32 vertex_count;
+
+    // NOTE: ChunkState in the low bits and the slot token above, see ChunkState
+    SDL_atomic_t state;
 
-    u32 vao;
+    // NOTE: Cancelled when the chunk is unloaded, the generate and mesh stages stop early
+    JobHandle job_handle;
 
-    b32 is_loaded;
-    b32 just_loaded;
+    // NOTE: The rest is only touched by the main thread. Job pushed for the chunk that the main
+    // thread has not integrated yet
+    ChunkJob job;
+    // NOTE: From the load until the first mesh is integrated, the chunk cannot be evicted
+    b32 is_loading;
+    // NOTE: A neighbor finished generating after the chunk was meshed without it
+    b32 needs_remesh;
+
+    // NOTE: The mesh job runs once the chunk and the neighbors that were still generating when it
+    // was loaded (one bit per ChunkNeighbor in pending_neighbors) are generated
+    JobCounter mesh_dependencies;
+    u32 pending_neighbors;
+    // NOTE: Generated neighbors read by the mesh job, they are pinned until the mesh completes
+    struct Chunk *neighbors[CHUNK_NEIGHBOR_COUNT];
+    u32 pin_count;
+    // NOTE: Slice of the staging ring behind the staging memory, -1 without one
+    s32 staging_slice;
+    // NOTE: When the mesh was integrated, the upload latency is measured from here
+    u64 meshed_ticks;
 
 } Chunk;
 
+void chunk_set_world_seed(s32 seed);
+void chunk_set_mesher(ChunkMesher mesher);
+ChunkMesher chunk_get_mesher(void);
+
+void chunk_initialize(Chunk *chunk);
+void chunk_release(Chunk *chunk);
+// NOTE: Free the mesh unless it lives in the staging memory
+void chunk_release_geometry(Chunk *chunk);
+
+Voxel chunk_get_voxel(Chunk *chunk, u32 x, u32 y, u32 z);
+void chunk_set_voxel(Chunk *chunk, u32 x, u32 y, u32 z, Voxel voxel);
+void chunk_pack_voxels(Chunk *chunk, Voxel *voxels);
+void chunk_unpack_voxels(Chunk *chunk, Voxel *voxels);
+u32 chunk_get_voxels_size(Chunk *chunk);
+void chunk_get_section_stats(Chunk *chunk, ChunkSectionStats *stats);
+
 void chunk_generate_voxels(Chunk *chunk);
-void chunk_generate_geometry(Chunk *chunk);
+// NOTE: neighbors holds CHUNK_NEIGHBOR_COUNT chunks with their voxels generated, the array or any
+// of its chunks can be NULL and the border uses the predicted terrain height instead
+void chunk_generate_geometry(Chunk *chunk, Chunk **neighbors);
 
 #endif // _CHUNK_H_
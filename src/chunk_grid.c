@@ -0,0 +1,54 @@
+#include "chunk_grid.h"
+
+// NOTE: Chunk grid -----------------------------------------------------
+
+static inline Chunk **chunk_grid_cell(ChunkGrid *grid, s32 x, s32 z) {
+    u32 cell_x = (u32)x & (CHUNK_GRID_DIM - 1);
+    u32 cell_z = (u32)z & (CHUNK_GRID_DIM - 1);
+    return grid->cells + cell_z * CHUNK_GRID_DIM + cell_x;
+}
+
+void chunk_grid_initialize(ChunkGrid *grid) {
+    chunk_grid_clear(grid);
+}
+
+Chunk *chunk_grid_get(ChunkGrid *grid, s32 x, s32 z) {
+    Chunk *chunk = (Chunk *)SDL_AtomicGetPtr((void **)chunk_grid_cell(grid, x, z));
+    if(chunk && chunk->x == x && chunk->z == z) {
+        return chunk;
+    }
+    return NULL;
+}
+
+Chunk *chunk_grid_get_neighbor(ChunkGrid *grid, Chunk *chunk, s32 dx, s32 dz) {
+    return chunk_grid_get(grid, chunk->x + dx, chunk->z + dz);
+}
+
+Chunk *chunk_grid_insert(ChunkGrid *grid, Chunk *chunk) {
+    Chunk **cell = chunk_grid_cell(grid, chunk->x, chunk->z);
+    Chunk *old   = *cell;
+    assert(old != chunk);
+    SDL_AtomicSetPtr((void **)cell, chunk);
+    if(!old) {
+        grid->count += 1;
+    }
+    return old;
+}
+
+void chunk_grid_remove(ChunkGrid *grid, Chunk *chunk) {
+    Chunk **cell = chunk_grid_cell(grid, chunk->x, chunk->z);
+    // NOTE: The cell may already belong to the chunk that displaced this one
+    if(*cell == chunk) {
+        SDL_AtomicSetPtr((void **)cell, NULL);
+        grid->count -= 1;
+    }
+}
+
+void chunk_grid_clear(ChunkGrid *grid) {
+    for(u32 i = 0; i < CHUNK_GRID_SIZE; ++i) {
+        SDL_AtomicSetPtr((void **)(grid->cells + i), NULL);
+    }
+    grid->count = 0;
+}
+
+// ----------------------------------------------------------------------
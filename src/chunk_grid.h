@@ -0,0 +1,30 @@
+#ifndef _CHUNK_GRID_H_
+#define _CHUNK_GRID_H_
+
+#include "os.h"
+#include "chunk.h"
+
+// NOTE: Toroidal grid of the chunks around the camera. Chunk (x, z) always lives in the cell
+// (x mod CHUNK_GRID_DIM, z mod CHUNK_GRID_DIM), so lookups and neighbor access are index
+// arithmetic with no hashing. The grid is wider than the load window plus the eviction margin,
+// a cell taken by another chunk means that chunk is out of the window and has to be evicted.
+// Same threading rules as the chunk map: the main thread writes, any thread reads
+
+#define CHUNK_GRID_DIM 64 // NOTE: Power of two
+#define CHUNK_GRID_SIZE (CHUNK_GRID_DIM * CHUNK_GRID_DIM)
+
+typedef struct ChunkGrid {
+    Chunk *cells[CHUNK_GRID_SIZE];
+    u32 count;
+} ChunkGrid;
+
+void chunk_grid_initialize(ChunkGrid *grid);
+
+Chunk *chunk_grid_get(ChunkGrid *grid, s32 x, s32 z);
+Chunk *chunk_grid_get_neighbor(ChunkGrid *grid, Chunk *chunk, s32 dx, s32 dz);
+// NOTE: Returns the chunk that used the cell before, NULL if it was empty
+Chunk *chunk_grid_insert(ChunkGrid *grid, Chunk *chunk);
+void chunk_grid_remove(ChunkGrid *grid, Chunk *chunk);
+void chunk_grid_clear(ChunkGrid *grid);
+
+#endif // _CHUNK_GRID_H_
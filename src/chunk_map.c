@@ -0,0 +1,173 @@
+#include "chunk_map.h"
+
+// NOTE: Chunk map ------------------------------------------------------
+
+// NOTE: The coordinates (-32768, -32768) and (-32767, -32768) are reserved for the empty and
+// removed slots
+#define CHUNK_MAP_EMPTY_KEY 0x80008000u
+#define CHUNK_MAP_TOMBSTONE_KEY 0x80008001u
+
+static inline u32 chunk_map_pack_key(s32 x, s32 z) {
+    assert(x >= INT16_MIN && x <= INT16_MAX && z >= INT16_MIN && z <= INT16_MAX);
+    return (u32)(u16)(s16)x | ((u32)(u16)(s16)z << 16);
+}
+
+// NOTE: murmur3 finalizer, spreads neighbor coordinates over the whole table
+static inline u32 chunk_map_hash(u32 key) {
+    key ^= key >> 16;
+    key *= 0x85ebca6bu;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35u;
+    key ^= key >> 16;
+    return key;
+}
+
+static void chunk_map_clear_slots(ChunkMapSlot *slots) {
+    for(u32 i = 0; i < CHUNK_MAP_CAPACITY; ++i) {
+        SDL_AtomicSet(&slots[i].key, (s32)CHUNK_MAP_EMPTY_KEY);
+        SDL_AtomicSetPtr((void **)&slots[i].chunk, NULL);
+    }
+}
+
+// NOTE: Returns true if the chunk took the slot of a removed one
+static b32 chunk_map_insert_slot(ChunkMapSlot *slots, u32 key, Chunk *chunk) {
+    u32 mask  = CHUNK_MAP_CAPACITY - 1;
+    u32 index = chunk_map_hash(key) & mask;
+    for(;;) {
+        u32 slot_key = (u32)SDL_AtomicGet(&slots[index].key);
+        if(slot_key == CHUNK_MAP_EMPTY_KEY || slot_key == CHUNK_MAP_TOMBSTONE_KEY) {
+            // NOTE: Publish the chunk before the key, readers match the key first
+            SDL_AtomicSetPtr((void **)&slots[index].chunk, chunk);
+            SDL_AtomicSet(&slots[index].key, (s32)key);
+            return slot_key == CHUNK_MAP_TOMBSTONE_KEY;
+        }
+        assert(slot_key != key);
+        index = (index + 1) & mask;
+    }
+}
+
+// NOTE: Rehash the live chunks into the other slot array and publish it, readers still probing
+// the old array see it unchanged until the next rebuild
+static void chunk_map_rebuild(ChunkMap *map) {
+    ChunkMapSlot *old_slots = map->slots;
+    ChunkMapSlot *new_slots = old_slots == map->buffers[0] ? map->buffers[1] : map->buffers[0];
+
+    chunk_map_clear_slots(new_slots);
+    for(u32 i = 0; i < CHUNK_MAP_CAPACITY; ++i) {
+        u32 key = (u32)SDL_AtomicGet(&old_slots[i].key);
+        if(key != CHUNK_MAP_EMPTY_KEY && key != CHUNK_MAP_TOMBSTONE_KEY) {
+            chunk_map_insert_slot(new_slots, key, old_slots[i].chunk);
+        }
+    }
+
+    SDL_AtomicSetPtr((void **)&map->slots, new_slots);
+    map->tombstone_count = 0;
+    map->rebuild_count += 1;
+}
+
+void chunk_map_initialize(ChunkMap *map) {
+    memset(map, 0, sizeof(*map));
+    map->buffers[0] = (ChunkMapSlot *)malloc(sizeof(ChunkMapSlot) * CHUNK_MAP_CAPACITY);
+    map->buffers[1] = (ChunkMapSlot *)malloc(sizeof(ChunkMapSlot) * CHUNK_MAP_CAPACITY);
+    chunk_map_clear_slots(map->buffers[0]);
+    map->slots = map->buffers[0];
+}
+
+void chunk_map_terminate(ChunkMap *map) {
+    free(map->buffers[0]);
+    free(map->buffers[1]);
+    memset(map, 0, sizeof(*map));
+}
+
+Chunk *chunk_map_get(ChunkMap *map, s32 x, s32 z) {
+    ChunkMapSlot *slots = (ChunkMapSlot *)SDL_AtomicGetPtr((void **)&map->slots);
+
+    u32 key   = chunk_map_pack_key(x, z);
+    u32 mask  = CHUNK_MAP_CAPACITY - 1;
+    u32 index = chunk_map_hash(key) & mask;
+    for(u32 probe = 0; probe < CHUNK_MAP_CAPACITY; ++probe) {
+        u32 slot_key = (u32)SDL_AtomicGet(&slots[index].key);
+        if(slot_key == CHUNK_MAP_EMPTY_KEY) {
+            return NULL;
+        }
+        if(slot_key == key) {
+            Chunk *chunk = (Chunk *)SDL_AtomicGetPtr((void **)&slots[index].chunk);
+            if(chunk && chunk->x == x && chunk->z == z) {
+                return chunk;
+            }
+        }
+        index = (index + 1) & mask;
+    }
+
+    return NULL;
+}
+
+void chunk_map_insert(ChunkMap *map, Chunk *chunk) {
+    assert(map->count < CHUNK_MAP_CAPACITY / 2);
+    if(chunk_map_insert_slot(map->slots, chunk_map_pack_key(chunk->x, chunk->z), chunk)) {
+        assert(map->tombstone_count > 0);
+        map->tombstone_count -= 1;
+    }
+    map->count += 1;
+}
+
+void chunk_map_remove(ChunkMap *map, Chunk *chunk) {
+    ChunkMapSlot *slots = map->slots;
+
+    u32 key   = chunk_map_pack_key(chunk->x, chunk->z);
+    u32 mask  = CHUNK_MAP_CAPACITY - 1;
+    u32 index = chunk_map_hash(key) & mask;
+    for(;;) {
+        u32 slot_key = (u32)SDL_AtomicGet(&slots[index].key);
+        if(slot_key == CHUNK_MAP_EMPTY_KEY) {
+            assert(!"chunk not in the map");
+            return;
+        }
+        if(slot_key == key && slots[index].chunk == chunk) {
+            SDL_AtomicSet(&slots[index].key, (s32)CHUNK_MAP_TOMBSTONE_KEY);
+            SDL_AtomicSetPtr((void **)&slots[index].chunk, NULL);
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+
+    map->count -= 1;
+    map->tombstone_count += 1;
+    if(map->tombstone_count > CHUNK_MAP_MAX_TOMBSTONES) {
+        chunk_map_rebuild(map);
+    }
+}
+
+void chunk_map_clear(ChunkMap *map) {
+    chunk_map_clear_slots(map->slots);
+    map->count           = 0;
+    map->tombstone_count = 0;
+}
+
+ChunkMapStats chunk_map_get_stats(ChunkMap *map) {
+    ChunkMapStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.count           = map->count;
+    stats.tombstone_count = map->tombstone_count;
+    stats.rebuild_count   = map->rebuild_count;
+
+    u64 total_probe_length = 0;
+    u32 mask               = CHUNK_MAP_CAPACITY - 1;
+    for(u32 i = 0; i < CHUNK_MAP_CAPACITY; ++i) {
+        u32 key = (u32)SDL_AtomicGet(&map->slots[i].key);
+        if(key == CHUNK_MAP_EMPTY_KEY || key == CHUNK_MAP_TOMBSTONE_KEY) {
+            continue;
+        }
+        u32 probe_length = ((i - chunk_map_hash(key)) & mask) + 1;
+        total_probe_length += probe_length;
+        if(probe_length > stats.max_probe_length)
+            stats.max_probe_length = probe_length;
+    }
+    if(stats.count) {
+        stats.average_probe_length = (f64)total_probe_length / (f64)stats.count;
+    }
+
+    return stats;
+}
+
+// ----------------------------------------------------------------------
@@ -0,0 +1,48 @@
+#ifndef _CHUNK_MAP_H_
+#define _CHUNK_MAP_H_
+
+#include "os.h"
+#include "chunk.h"
+
+// NOTE: Open addressing map from chunk (x, z) to the chunk. Keys are the coordinates packed as two
+// s16 in a 32 bit value and probed linearly from a mixing hash. Only the main thread writes to
+// the map, the worker threads can look chunks up at any time without locks: a slot publishes its
+// chunk before its key, and readers check the chunk coordinates to catch slots reused under them.
+// Removed keys leave a tombstone, once there are too many the map is rebuilt into the second slot
+// array and the arrays are swapped
+
+#define CHUNK_MAP_CAPACITY 4096 // NOTE: Power of two, twice the chunk buffer
+#define CHUNK_MAP_MAX_TOMBSTONES (CHUNK_MAP_CAPACITY / 4)
+
+typedef struct ChunkMapSlot {
+    SDL_atomic_t key;
+    Chunk *chunk;
+} ChunkMapSlot;
+
+typedef struct ChunkMap {
+    ChunkMapSlot *slots; // NOTE: Read with SDL_AtomicGetPtr, swapped on rebuild
+    ChunkMapSlot *buffers[2];
+    u32 count;
+    u32 tombstone_count;
+    u32 rebuild_count;
+} ChunkMap;
+
+typedef struct ChunkMapStats {
+    u32 count;
+    u32 tombstone_count;
+    u32 rebuild_count;
+    u32 max_probe_length;
+    f64 average_probe_length;
+} ChunkMapStats;
+
+void chunk_map_initialize(ChunkMap *map);
+void chunk_map_terminate(ChunkMap *map);
+
+Chunk *chunk_map_get(ChunkMap *map, s32 x, s32 z);
+void chunk_map_insert(ChunkMap *map, Chunk *chunk);
+void chunk_map_remove(ChunkMap *map, Chunk *chunk);
+void chunk_map_clear(ChunkMap *map);
+
+ChunkMapStats chunk_map_get_stats(ChunkMap *map);
+
+#endif // _CHUNK_MAP_H_
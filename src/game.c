@@ -2,25 +2,41 @@
 #include "os.h"
 #include "job.h"
 
-#include <glad/glad.h>
-
 static void game_allocate_chunk_buffer(Game *game) {
 
     game->chunk_buffer_count = (u32)((MAX_CHUNKS_X * MAX_CHUNKS_Y) * 2);
+    // NOTE: Chunk handles hold the index in 16 bits, the vertices in 12 bits
+    assert(game->chunk_buffer_count <= 0x10000 && game->chunk_buffer_count <= VERTEX_MAX_SLOTS);
     game->chunk_buffer       = (Chunk *)malloc(sizeof(Chunk) * game->chunk_buffer_count);
 
     printf("chunk: %lld\n", sizeof(game->chunk_buffer[0]));
-    printf("chunk voxels size: %lld\n", sizeof(game->chunk_buffer[0].voxels));
-    printf("chunk vertex size: %lld\n", sizeof(game->chunk_buffer[0].geometry));
+    printf("chunk voxels size: %lld\n", sizeof(game->chunk_buffer[0].sections));
     printf("total chunk buffer size: %lld\n", (u64)(sizeof(Chunk) * game->chunk_buffer_count));
 
     for(u32 chunk_id = 0; chunk_id < game->chunk_buffer_count; ++chunk_id) {
         Chunk *chunk          = &game->chunk_buffer[chunk_id];
-        chunk->vao            = gpu_load_buffer(NULL, 0);
-        chunk->geometry_count = 0;
+        chunk_initialize(chunk);
+        chunk->vertex_slot   = chunk_id;
+        chunk->staging_slice = -1;
     }
 }
 
+static void game_setup_vertex_arena(Game *game) {
+    gpu_arena_initialize(&game->vertex_arena, GPU_ARENA_INITIAL_CAPACITY);
+    if(gpu_staging_initialize(&game->staging_ring)) {
+        printf("staging ring: %d MB persistently mapped\n",
+               (GPU_STAGING_SLICE_SIZE * GPU_STAGING_SLICE_COUNT) / (1024 * 1024));
+    } else {
+        printf("staging ring: no ARB_buffer_storage, meshes are uploaded from the cpu\n");
+    }
+    game->chunk_origins_texture =
+        gpu_load_texture_buffer(&game->chunk_origins_buffer, game->chunk_buffer_count);
+
+    game->uploads     = (ChunkUpload *)malloc(sizeof(ChunkUpload) * game->chunk_buffer_count);
+    game->draw_firsts = (s32 *)malloc(sizeof(s32) * game->chunk_buffer_count);
+    game->draw_counts = (s32 *)malloc(sizeof(s32) * game->chunk_buffer_count);
+}
+
 static void game_setup_buffer_freelist(Game *game) {
 
     list_init(&game->free_chunks_list);
@@ -31,138 +47,882 @@ static void game_setup_buffer_freelist(Game *game) {
     }
 }
 
-static void game_setup_hash_chunk_table(Game *game) {
-    list_init(&game->loaded_chunks_list);
+static void game_setup_completion_queue(Game *game) {
+    ChunkCompletionQueue *queue = &game->completed_chunks;
+    queue->lock                 = 0;
+    queue->capacity             = game->chunk_buffer_count;
+    queue->handles              = (ChunkHandle *)malloc(sizeof(ChunkHandle) * queue->capacity);
+    queue->first                = 0;
+    queue->count                = 0;
+}
+
+static void game_push_completed_chunk(Game *game, ChunkHandle handle) {
+    ChunkCompletionQueue *queue = &game->completed_chunks;
+    SDL_AtomicLock(&queue->lock);
+    assert(queue->count < queue->capacity);
+    queue->handles[(queue->first + queue->count) % queue->capacity] = handle;
+    queue->count += 1;
+    SDL_AtomicUnlock(&queue->lock);
+}
 
-    for(u32 i = 0; i < GAME_CHUNK_HASH_SIZE; ++i) {
-        list_init_named(&game->hash_chunks[i], hash);
+static b32 game_pop_completed_chunk(Game *game, ChunkHandle *handle) {
+    ChunkCompletionQueue *queue = &game->completed_chunks;
+    b32 success                 = false;
+    SDL_AtomicLock(&queue->lock);
+    if(queue->count > 0) {
+        *handle      = queue->handles[queue->first];
+        queue->first = (queue->first + 1) % queue->capacity;
+        queue->count -= 1;
+        success = true;
     }
+    SDL_AtomicUnlock(&queue->lock);
+    return success;
 }
 
-static u32 game_get_hash_from_xz(s32 x, s32 z) {
-    // TODO: Write an actual hash funciton
-    return ((u32)x * 7 + (u32)z * 73) % GAME_CHUNK_HASH_SIZE;
+static void game_setup_chunk_map(Game *game) {
+    list_init(&game->loaded_chunks_list);
+#if GAME_USE_CHUNK_GRID
+    chunk_grid_initialize(&game->chunk_grid);
+#else
+    chunk_map_initialize(&game->chunk_map);
+#endif
 }
 
-static Chunk *game_get_farthest_chunk(Game *game, s32 x, s32 z) {
+static void game_setup_evict_buckets(Game *game) {
+    for(u32 i = 0; i < GAME_CHUNK_EVICT_BUCKET_COUNT; ++i) {
+        list_init_named(&game->evict_columns[i], column);
+        list_init_named(&game->evict_rows[i], row);
+    }
+    game->evict_distance = GAME_CHUNK_EVICT_BUCKET_COUNT / 2;
+}
 
-    f32 distance  = 0;
-    Chunk *result = NULL;
+Game g;
 
-    ChunkNode *chunk_node = list_get_top(&game->loaded_chunks_list);
+static inline u32 game_get_evict_bucket(s32 coordinate) {
+    return (u32)coordinate & (GAME_CHUNK_EVICT_BUCKET_COUNT - 1);
+}
 
-    while(!list_is_end(&game->loaded_chunks_list, chunk_node)) {
-        Chunk *chunk  = (Chunk *)chunk_node;
-        V3 chunk_pos  = v3((f32)chunk->x, 0, (f32)chunk->z);
-        V3 cam_to_pos = v3_sub(chunk_pos, v3((f32)x, 0, (f32)z));
-        f32 temp      = v3_length(cam_to_pos);
+// NOTE: No chunk moves between buckets, the chunks only get as much farther as the camera chunk
+// moved so the scan starts that much farther out
+static void game_update_evict_center(s32 center_x, s32 center_z) {
+    s32 dx           = abs(center_x - g.evict_center_x);
+    s32 dz           = abs(center_z - g.evict_center_z);
+    g.evict_center_x = center_x;
+    g.evict_center_z = center_z;
+    g.evict_distance += dx > dz ? dx : dz;
+    if(g.evict_distance > GAME_CHUNK_EVICT_BUCKET_COUNT / 2) {
+        g.evict_distance = GAME_CHUNK_EVICT_BUCKET_COUNT / 2;
+    }
+}
 
-        if(distance < temp) {
-            distance = temp;
-            result   = chunk;
-        }
+// NOTE: Chunks owned by a job or pinned by a neighbor mesh cannot be evicted
+static inline b32 game_chunk_is_evictable(Chunk *chunk) {
+    return !chunk->is_loading && chunk->job == CHUNK_JOB_NONE && chunk->pin_count == 0;
+}
 
-        chunk_node = chunk_node->next;
+static Chunk *game_get_evictable_in_column(ChunkNode *bucket) {
+    ChunkNode *chunk_node = list_get_top_named(bucket, column);
+    while(!list_is_end_named(bucket, chunk_node, column)) {
+        if(game_chunk_is_evictable((Chunk *)chunk_node)) {
+            return (Chunk *)chunk_node;
+        }
+        chunk_node = chunk_node->next_column;
     }
-
-    assert(result);
-    return result;
+    return NULL;
 }
 
-Game g;
+static Chunk *game_get_evictable_in_row(ChunkNode *bucket) {
+    ChunkNode *chunk_node = list_get_top_named(bucket, row);
+    while(!list_is_end_named(bucket, chunk_node, row)) {
+        if(game_chunk_is_evictable((Chunk *)chunk_node)) {
+            return (Chunk *)chunk_node;
+        }
+        chunk_node = chunk_node->next_row;
+    }
+    return NULL;
+}
 
-Chunk *game_get_chunk(s32 x, s32 z) {
-    u32 hash          = game_get_hash_from_xz(x, z);
-    ChunkNode *bucket = g.hash_chunks + hash;
+// NOTE: Any chunk of the farthest non empty ring outside the window and its margin. The buckets
+// at distance d from the camera chunk (up to half the bucket count) only hold chunks at a
+// chebyshev distance of d or more, so the first evictable chunk found walking the distance down
+// is one of the farthest
+static Chunk *game_get_chunk_to_evict(void) {
+    s32 min_distance = (MAX_CHUNKS_X > MAX_CHUNKS_Y ? MAX_CHUNKS_X : MAX_CHUNKS_Y) / 2 +
+                       GAME_CHUNK_EVICT_MARGIN + 1;
+
+    b32 buckets_empty = true;
+    for(s32 distance = g.evict_distance; distance >= min_distance; --distance) {
+        ChunkNode *columns[2] = {
+            g.evict_columns + game_get_evict_bucket(g.evict_center_x - distance),
+            g.evict_columns + game_get_evict_bucket(g.evict_center_x + distance),
+        };
+        ChunkNode *rows[2] = {
+            g.evict_rows + game_get_evict_bucket(g.evict_center_z - distance),
+            g.evict_rows + game_get_evict_bucket(g.evict_center_z + distance),
+        };
+
+        for(u32 i = 0; i < 2; ++i) {
+            Chunk *chunk = game_get_evictable_in_column(columns[i]);
+            if(!chunk) {
+                chunk = game_get_evictable_in_row(rows[i]);
+            }
+            if(chunk) {
+                return chunk;
+            }
+            buckets_empty = buckets_empty && list_is_empty_named(columns[i], column) &&
+                            list_is_empty_named(rows[i], row);
+        }
 
-    if(list_is_empty_named(bucket, hash)) {
-        return NULL;
+        // NOTE: Chunks only get farther when the camera moves, the empty buckets stay empty
+        if(buckets_empty) {
+            g.evict_distance = distance - 1;
+        }
     }
 
-    ChunkNode *chunk_node = list_get_top_named(bucket, hash);
-    while(!list_is_end_named(bucket, chunk_node, hash)) {
+    // NOTE: A chunk farther than half the bucket count can share a bucket with the closer
+    // columns or rows, look for one before giving up
+    ChunkNode *chunk_node = list_get_top(&g.loaded_chunks_list);
+    while(!list_is_end(&g.loaded_chunks_list, chunk_node)) {
         Chunk *chunk = (Chunk *)chunk_node;
-        if(chunk->x == x && chunk->z == z) {
+        s32 dx       = abs(chunk->x - g.evict_center_x);
+        s32 dz       = abs(chunk->z - g.evict_center_z);
+        if((dx >= min_distance || dz >= min_distance) && game_chunk_is_evictable(chunk)) {
             return chunk;
         }
-        chunk_node = chunk_node->next_hash;
+        chunk_node = chunk_node->next;
     }
 
     return NULL;
 }
 
+// NOTE: Safe to call from the worker threads
+Chunk *game_get_chunk(s32 x, s32 z) {
+#if GAME_USE_CHUNK_GRID
+    return chunk_grid_get(&g.chunk_grid, x, z);
+#else
+    return chunk_map_get(&g.chunk_map, x, z);
+#endif
+}
+
 void game_insert_chunk(Chunk *chunk) {
-    u32 hash          = game_get_hash_from_xz(chunk->x, chunk->z);
-    ChunkNode *bucket = g.hash_chunks + hash;
-    list_insert_back_named(bucket, &chunk->header, hash);
     list_insert_back(&g.loaded_chunks_list, &chunk->header);
+    list_insert_back_named(g.evict_columns + game_get_evict_bucket(chunk->x), &chunk->header,
+                           column);
+    list_insert_back_named(g.evict_rows + game_get_evict_bucket(chunk->z), &chunk->header, row);
+#if GAME_USE_CHUNK_GRID
+    // NOTE: The chunk that used the cell slid out of the window
+    Chunk *displaced_chunk = chunk_grid_insert(&g.chunk_grid, chunk);
+    if(displaced_chunk) {
+        game_chunk_unload(displaced_chunk);
+    }
+#else
+    chunk_map_insert(&g.chunk_map, chunk);
+#endif
 }
 
 void game_remove_chunk(Chunk *chunk) {
-    // NOTE: Remove chunk from loaded chunk hash
-    list_remove_named(&chunk->header, hash);
+    // NOTE: Remove chunk from loaded chunk map
+#if GAME_USE_CHUNK_GRID
+    chunk_grid_remove(&g.chunk_grid, chunk);
+#else
+    chunk_map_remove(&g.chunk_map, chunk);
+#endif
     list_remove(&chunk->header);
+    list_remove_named(&chunk->header, column);
+    list_remove_named(&chunk->header, row);
 }
 
 b32 game_chunk_is_loaded(s32 x, s32 z) {
     Chunk *chunk = game_get_chunk(x, z);
-    if(chunk && chunk->is_loaded) {
+    if(chunk && !chunk->is_loading) {
         return true;
     }
     return false;
 }
 
-int chunk_generate_voxels_and_geometry_job(void *data) {
+static s32 game_neighbor_offsets[CHUNK_NEIGHBOR_COUNT][2] = {
+    [CHUNK_NEIGHBOR_BACK]  = { 0, -1 },
+    [CHUNK_NEIGHBOR_FRONT] = { 0, 1 },
+    [CHUNK_NEIGHBOR_LEFT]  = { -1, 0 },
+    [CHUNK_NEIGHBOR_RIGHT] = { 1, 0 },
+};
+
+// NOTE: The side of the neighbor that faces the chunk, the opposite sides are consecutive
+static inline u32 game_opposite_neighbor(u32 neighbor) {
+    return neighbor ^ 1;
+}
+
+static Chunk *game_get_neighbor(Chunk *chunk, u32 neighbor) {
+    return game_get_chunk(chunk->x + game_neighbor_offsets[neighbor][0],
+                          chunk->z + game_neighbor_offsets[neighbor][1]);
+}
+
+// NOTE: Chunk state word and handles ---------------------------------
+
+static inline s32 game_chunk_state_word(u32 token, ChunkState state) {
+    return (s32)(((token & GAME_CHUNK_TOKEN_MASK) << GAME_CHUNK_STATE_BITS) | state);
+}
+
+static inline ChunkState game_get_chunk_state(Chunk *chunk) {
+    return (ChunkState)(SDL_AtomicGet(&chunk->state) & ((1 << GAME_CHUNK_STATE_BITS) - 1));
+}
+
+static inline u32 game_get_chunk_token(Chunk *chunk) {
+    return (u32)SDL_AtomicGet(&chunk->state) >> GAME_CHUNK_STATE_BITS;
+}
+
+// NOTE: Fails if the chunk is not in the from state anymore or was recycled since the token was
+// read, the transitions that can race with the main thread go through here
+static inline b32 game_chunk_transition(Chunk *chunk, u32 token, ChunkState from, ChunkState to) {
+    return SDL_AtomicCAS(&chunk->state, game_chunk_state_word(token, from),
+                         game_chunk_state_word(token, to));
+}
+
+// NOTE: Main thread only, for the transitions no job can race with
+static inline void game_set_chunk_state(Chunk *chunk, ChunkState state) {
+    SDL_AtomicSet(&chunk->state, game_chunk_state_word(game_get_chunk_token(chunk), state));
+}
+
+// NOTE: Index in the chunk buffer, also the slot of the chunk origin in the gpu
+static inline u32 game_get_chunk_slot(Chunk *chunk) {
+    return (u32)(chunk - g.chunk_buffer);
+}
+
+static inline ChunkHandle game_get_chunk_handle(Chunk *chunk) {
+    return (ChunkHandle)game_get_chunk_slot(chunk) | (game_get_chunk_token(chunk) << 16);
+}
+
+static inline Chunk *game_get_handle_chunk(ChunkHandle handle) {
+    return g.chunk_buffer + (handle & 0xffff);
+}
+
+static inline u32 game_get_handle_token(ChunkHandle handle) {
+    return handle >> 16;
+}
+
+static inline b32 game_chunk_has_voxels(Chunk *chunk) {
+    ChunkState state = game_get_chunk_state(chunk);
+    return state >= CHUNK_STATE_GENERATED && state <= CHUNK_STATE_UPLOADED;
+}
+
+static char *chunk_state_names[CHUNK_STATE_COUNT] = {
+    [CHUNK_STATE_FREE]       = "free",
+    [CHUNK_STATE_QUEUED]     = "queued",
+    [CHUNK_STATE_GENERATING] = "generating",
+    [CHUNK_STATE_GENERATED]  = "generated",
+    [CHUNK_STATE_MESHING]    = "meshing",
+    [CHUNK_STATE_MESHED]     = "meshed",
+    [CHUNK_STATE_UPLOADED]   = "uploaded",
+    [CHUNK_STATE_EVICTING]   = "evicting",
+};
+
+void game_get_chunk_state_counts(u32 *counts) {
+    memset(counts, 0, sizeof(u32) * CHUNK_STATE_COUNT);
+    for(u32 chunk_id = 0; chunk_id < g.chunk_buffer_count; ++chunk_id) {
+        counts[game_get_chunk_state(g.chunk_buffer + chunk_id)] += 1;
+    }
+}
+
+static void game_print_chunk_states(void) {
+    u32 counts[CHUNK_STATE_COUNT];
+    game_get_chunk_state_counts(counts);
+    printf("chunks:");
+    for(u32 state = 0; state < CHUNK_STATE_COUNT; ++state) {
+        printf(" %s %u", chunk_state_names[state], counts[state]);
+    }
+    printf(", %u in flight, %u waiting remesh\n", g.chunks_in_flight, g.remesh_count);
+    printf("jobs: %.1f completed/s, %.1f cancelled/s\n", g.jobs_completed_per_second,
+           g.jobs_cancelled_per_second);
+    printf("last frame: %u chunks drawn, %u culled\n", g.chunks_drawn, g.chunks_culled);
+    printf("last frame: %u uploads (%u staged, %u KB), %u waiting, latency %.2f ms average %.2f "
+           "ms max\n",
+           g.upload_count, g.upload_staged_count, g.upload_bytes / 1024, g.uploads_pending,
+           g.upload_latency_average_ms, g.upload_latency_max_ms);
+    GpuFrameStats gpu_stats = gpu_get_frame_stats();
+    printf("last frame: %u gl calls, %u redundant binds skipped\n", gpu_stats.calls,
+           gpu_stats.skipped_calls);
+}
+
+static void game_update_job_rates(f32 dt) {
+    g.job_rates_time += dt;
+    if(g.job_rates_time < 1.0f) {
+        return;
+    }
+
+    JobStats stats              = job_get_stats();
+    g.jobs_completed_per_second = (f32)(stats.completed - g.job_stats.completed) / g.job_rates_time;
+    g.jobs_cancelled_per_second = (f32)(stats.cancelled - g.job_stats.cancelled) / g.job_rates_time;
+    g.job_stats                 = stats;
+    g.job_rates_time            = 0;
+}
+
+// ----------------------------------------------------------------------
+
+// NOTE: A job whose chunk was unloaded before it started does nothing and reports nothing, the
+// main thread already took the chunk back. A job that started always reports, even if the chunk
+// was unloaded and the job cancelled halfway
+int chunk_generate_voxels_job(void *data) {
+
+    ChunkHandle handle = (ChunkHandle)(uintptr_t)data;
+    Chunk *chunk       = game_get_handle_chunk(handle);
+    u32 token          = game_get_handle_token(handle);
+
+    if(!game_chunk_transition(chunk, token, CHUNK_STATE_QUEUED, CHUNK_STATE_GENERATING)) {
+        return JOB_CANCELLED;
+    }
 
-    Chunk *chunk = (Chunk *)data;
     chunk_generate_voxels(chunk);
-    chunk_generate_geometry(chunk);
+    b32 done = game_chunk_transition(chunk, token, CHUNK_STATE_GENERATING, CHUNK_STATE_GENERATED);
+
+    // NOTE: The main thread integrates the chunk when it drains the completion queue
+    game_push_completed_chunk(&g, handle);
+
+    return done ? JOB_DONE : JOB_CANCELLED;
+}
+
+int chunk_generate_geometry_job(void *data) {
+
+    ChunkHandle handle = (ChunkHandle)(uintptr_t)data;
+    Chunk *chunk       = game_get_handle_chunk(handle);
+    u32 token          = game_get_handle_token(handle);
+
+    if(!game_chunk_transition(chunk, token, CHUNK_STATE_GENERATED, CHUNK_STATE_MESHING)) {
+        return JOB_CANCELLED;
+    }
+
+    chunk_generate_geometry(chunk, chunk->neighbors);
+    b32 done = game_chunk_transition(chunk, token, CHUNK_STATE_MESHING, CHUNK_STATE_MESHED);
+
+    game_push_completed_chunk(&g, handle);
+
+    return done ? JOB_DONE : JOB_CANCELLED;
+}
+
+static ThreadJob game_get_chunk_job(Chunk *chunk, ChunkJob chunk_job) {
+    ThreadJob job;
+    job.run    = chunk_job == CHUNK_JOB_GENERATE ? chunk_generate_voxels_job
+                                                 : chunk_generate_geometry_job;
+    job.args   = (void *)(uintptr_t)game_get_chunk_handle(chunk);
+    job.handle = &chunk->job_handle;
+    return job;
+}
+
+static void game_push_chunk_job(Chunk *chunk, ChunkJob chunk_job) {
+    push_job(game_get_chunk_job(chunk, chunk_job));
+    chunk->job = chunk_job;
+}
 
-    chunk->just_loaded = true;
-    chunk->is_loaded   = true;
+// NOTE: Hand a staging slice to the chunk right before its mesh job is pushed, without a free slice
+// the mesh goes to the mesh pool
+static void game_chunk_acquire_staging(Chunk *chunk) {
+    assert(chunk->staging_slice < 0);
+    s32 slice = gpu_staging_acquire(&g.staging_ring);
+    if(slice >= 0) {
+        chunk->staging_slice    = slice;
+        chunk->staging          = gpu_staging_get_slice(&g.staging_ring, (u32)slice);
+        chunk->staging_capacity = GPU_STAGING_SLICE_VERTICES;
+    }
+}
 
-    return 0;
+static void game_chunk_release_staging(Chunk *chunk) {
+    if(chunk->staging_slice < 0) {
+        return;
+    }
+    assert(chunk->geometry != chunk->staging);
+    gpu_staging_release(&g.staging_ring, (u32)chunk->staging_slice);
+    chunk->staging_slice    = -1;
+    chunk->staging          = NULL;
+    chunk->staging_capacity = 0;
+}
+
+// NOTE: Give an evicting chunk back to the free list once no job and no neighbor mesh uses it
+static void game_chunk_free_if_unused(Chunk *chunk) {
+    assert(game_get_chunk_state(chunk) == CHUNK_STATE_EVICTING);
+    if(chunk->job != CHUNK_JOB_NONE || chunk->pin_count > 0) {
+        return;
+    }
+
+    if(chunk->is_loading) {
+        chunk->is_loading = false;
+        g.chunks_in_flight -= 1;
+    }
+
+    // NOTE: Release the voxels and the staging mesh if the chunk never made it to the gpu
+    chunk_release(chunk);
+    game_chunk_release_staging(chunk);
+
+    // NOTE: New token, the handles of the jobs that never started do not match the slot anymore
+    SDL_AtomicSet(&chunk->state, game_chunk_state_word(game_get_chunk_token(chunk) + 1,
+                                                       CHUNK_STATE_FREE));
+    list_insert_front(&g.free_chunks_list, &chunk->header);
+}
+
+static void game_chunk_unpin(Chunk *chunk) {
+    assert(chunk->pin_count > 0);
+    chunk->pin_count -= 1;
+    if(game_get_chunk_state(chunk) == CHUNK_STATE_EVICTING) {
+        game_chunk_free_if_unused(chunk);
+    }
+}
+
+static void game_chunk_set_neighbor(Chunk *chunk, u32 neighbor, Chunk *neighbor_chunk) {
+    Chunk *old_neighbor = chunk->neighbors[neighbor];
+    if(old_neighbor == neighbor_chunk) {
+        return;
+    }
+    chunk->neighbors[neighbor] = neighbor_chunk;
+    neighbor_chunk->pin_count += 1;
+    if(old_neighbor) {
+        game_chunk_unpin(old_neighbor);
+    }
+}
+
+static void game_chunk_unpin_neighbors(Chunk *chunk) {
+    for(u32 i = 0; i < CHUNK_NEIGHBOR_COUNT; ++i) {
+        Chunk *neighbor = chunk->neighbors[i];
+        if(neighbor) {
+            chunk->neighbors[i] = NULL;
+            game_chunk_unpin(neighbor);
+        }
+    }
+}
+
+// NOTE: One of the dependencies of the first mesh of the chunk is done
+static void game_chunk_resolve_dependency(Chunk *chunk) {
+    // NOTE: Only the main thread decrements the counter, the last dependency pushes the mesh job
+    if(SDL_AtomicGet(&chunk->mesh_dependencies.value) == 1) {
+        game_chunk_acquire_staging(chunk);
+    }
+    if(job_counter_decrement(&chunk->mesh_dependencies)) {
+        chunk->job = CHUNK_JOB_MESH;
+    }
+}
+
+static void game_chunk_dispatch_mesh(Chunk *chunk) {
+    for(u32 i = 0; i < CHUNK_NEIGHBOR_COUNT; ++i) {
+        Chunk *neighbor = game_get_neighbor(chunk, i);
+        if(neighbor && game_chunk_has_voxels(neighbor)) {
+            game_chunk_set_neighbor(chunk, i, neighbor);
+        }
+    }
+
+    if(chunk->needs_remesh) {
+        chunk->needs_remesh = false;
+        g.remesh_count -= 1;
+    }
+
+    // NOTE: The chunk keeps drawing its uploaded mesh while the new one is built
+    game_set_chunk_state(chunk, CHUNK_STATE_GENERATED);
+    game_chunk_acquire_staging(chunk);
+    game_push_chunk_job(chunk, CHUNK_JOB_MESH);
+}
+
+// NOTE: The staging mesh has to be uploaded before it is rebuilt, chunks still meshing or waiting
+// for the upload are remeshed in a later frame
+static void game_chunk_request_remesh(Chunk *chunk) {
+    if(chunk->job != CHUNK_JOB_NONE || game_get_chunk_state(chunk) != CHUNK_STATE_UPLOADED) {
+        if(!chunk->needs_remesh) {
+            chunk->needs_remesh = true;
+            g.remesh_count += 1;
+        }
+        return;
+    }
+    game_chunk_dispatch_mesh(chunk);
+}
+
+static void game_dispatch_remeshes(void) {
+    if(g.remesh_count == 0) {
+        return;
+    }
+
+    ChunkNode *chunk_node = list_get_top(&g.loaded_chunks_list);
+    while(!list_is_end(&g.loaded_chunks_list, chunk_node)) {
+        Chunk *chunk = (Chunk *)chunk_node;
+        if(chunk->needs_remesh && chunk->job == CHUNK_JOB_NONE &&
+           game_get_chunk_state(chunk) == CHUNK_STATE_UPLOADED) {
+            game_chunk_dispatch_mesh(chunk);
+        }
+        chunk_node = chunk_node->next;
+    }
 }
 
 Chunk *game_chunk_load(s32 x, s32 z) {
 
     if(list_is_empty(&g.free_chunks_list)) {
-        Chunk *chunk_to_unload = game_get_farthest_chunk(&g, x, z);
+        Chunk *chunk_to_unload = game_get_chunk_to_evict();
+        if(!chunk_to_unload) {
+            return NULL;
+        }
         game_chunk_unload(chunk_to_unload);
     }
 
     ChunkNode *chunk_node = list_get_top(&g.free_chunks_list);
     list_remove(chunk_node);
 
-    Chunk *chunk          = (Chunk *)chunk_node;
-    chunk->x              = x;
-    chunk->z              = z;
-    chunk->geometry_count = 0;
+    Chunk *chunk = (Chunk *)chunk_node;
+    assert(game_get_chunk_state(chunk) == CHUNK_STATE_FREE);
+    chunk->x                 = x;
+    chunk->z                 = z;
+    chunk->geometry_count    = 0;
+    chunk->vertex_count      = 0;
+    chunk->is_loading        = true;
+    chunk->needs_remesh      = false;
+    chunk->pending_neighbors = 0;
+
+    // NOTE: Generated neighbors are pinned right away, the ones still generating are waited for
+    // and the missing ones use the predicted height until they load and the chunk is remeshed
+    u32 dependency_count = 1;
+    for(u32 i = 0; i < CHUNK_NEIGHBOR_COUNT; ++i) {
+        Chunk *neighbor = game_get_neighbor(chunk, i);
+        if(!neighbor) {
+            continue;
+        }
+        if(game_chunk_has_voxels(neighbor)) {
+            game_chunk_set_neighbor(chunk, i, neighbor);
+        } else {
+            chunk->pending_neighbors |= 1u << i;
+            dependency_count += 1;
+        }
+    }
+
+    game_set_chunk_state(chunk, CHUNK_STATE_QUEUED);
+    job_handle_reset(&chunk->job_handle);
+    job_counter_initialize(&chunk->mesh_dependencies, dependency_count,
+                           game_get_chunk_job(chunk, CHUNK_JOB_MESH));
 
     game_insert_chunk(chunk);
+    g.chunks_in_flight += 1;
 
-    ThreadJob job;
-    job.run  = chunk_generate_voxels_and_geometry_job;
-    job.args = (void *)chunk;
-    push_job(job);
+    game_push_chunk_job(chunk, CHUNK_JOB_GENERATE);
 
     return chunk;
 }
 
 void game_chunk_unload(Chunk *chunk) {
-    chunk->is_loaded = false;
+
+    // NOTE: Neighbors waiting for this chunk mesh against the predicted height instead
+    for(u32 i = 0; i < CHUNK_NEIGHBOR_COUNT; ++i) {
+        Chunk *neighbor = game_get_neighbor(chunk, i);
+        u32 side        = 1u << game_opposite_neighbor(i);
+        if(neighbor && (neighbor->pending_neighbors & side)) {
+            neighbor->pending_neighbors &= ~side;
+            game_chunk_resolve_dependency(neighbor);
+        }
+    }
+
     game_remove_chunk(chunk);
-    list_insert_front(&g.free_chunks_list, &chunk->header);
+    if(chunk->vertex_count > 0) {
+        gpu_arena_free(&g.vertex_arena, chunk->vertex_offset, chunk->vertex_count);
+        chunk->vertex_count = 0;
+    }
+    if(chunk->needs_remesh) {
+        chunk->needs_remesh = false;
+        g.remesh_count -= 1;
+    }
+
+    // NOTE: Race the job for the state, a job that has not started yet will see the chunk
+    // evicting and skip its work so the chunk does not have to wait for it
+    u32 token = game_get_chunk_token(chunk);
+    ChunkState state;
+    do {
+        state = game_get_chunk_state(chunk);
+    } while(!game_chunk_transition(chunk, token, state, CHUNK_STATE_EVICTING));
+
+    // NOTE: A queued job is skipped when it is popped, a running one stops at its next stage
+    if(chunk->job != CHUNK_JOB_NONE) {
+        job_cancel(&chunk->job_handle);
+    }
+    if((chunk->job == CHUNK_JOB_GENERATE && state == CHUNK_STATE_QUEUED) ||
+       (chunk->job == CHUNK_JOB_MESH && state == CHUNK_STATE_GENERATED)) {
+        chunk->job = CHUNK_JOB_NONE;
+    }
+
+    // NOTE: Only a running mesh job still reads the neighbors
+    if(chunk->job != CHUNK_JOB_MESH) {
+        game_chunk_unpin_neighbors(chunk);
+    }
+    game_chunk_free_if_unused(chunk);
+}
+
+static void game_chunk_generated(Chunk *chunk) {
+    if(game_get_chunk_state(chunk) == CHUNK_STATE_EVICTING) {
+        game_chunk_free_if_unused(chunk);
+        return;
+    }
+    assert(game_get_chunk_state(chunk) == CHUNK_STATE_GENERATED);
+
+    for(u32 i = 0; i < CHUNK_NEIGHBOR_COUNT; ++i) {
+        Chunk *neighbor = game_get_neighbor(chunk, i);
+        if(!neighbor) {
+            continue;
+        }
+
+        u32 side = game_opposite_neighbor(i);
+        if(neighbor->is_loading && neighbor->job != CHUNK_JOB_MESH) {
+            // NOTE: The first mesh of the neighbor is not running yet, it can still use this chunk
+            game_chunk_set_neighbor(neighbor, side, chunk);
+            if(neighbor->pending_neighbors & (1u << side)) {
+                neighbor->pending_neighbors &= ~(1u << side);
+                game_chunk_resolve_dependency(neighbor);
+            }
+        } else {
+            // NOTE: The neighbor was meshed with the predicted height on this side
+            game_chunk_request_remesh(neighbor);
+        }
+    }
+
+    game_chunk_resolve_dependency(chunk);
+}
+
+static void game_chunk_meshed(Chunk *chunk) {
+    game_chunk_unpin_neighbors(chunk);
+    if(game_get_chunk_state(chunk) == CHUNK_STATE_EVICTING) {
+        game_chunk_free_if_unused(chunk);
+        return;
+    }
+    assert(game_get_chunk_state(chunk) == CHUNK_STATE_MESHED);
+    chunk->meshed_ticks = SDL_GetPerformanceCounter();
+
+    if(chunk->is_loading) {
+        chunk->is_loading = false;
+        g.chunks_in_flight -= 1;
+    }
+}
+
+static void game_integrate_completed_chunks(void) {
+    for(u32 i = 0; i < GAME_CHUNK_INTEGRATE_BUDGET; ++i) {
+        ChunkHandle handle;
+        if(!game_pop_completed_chunk(&g, &handle)) {
+            break;
+        }
+
+        // NOTE: Slots are only recycled once their jobs are integrated or were skipped, and the
+        // skipped jobs never report
+        Chunk *chunk = game_get_handle_chunk(handle);
+        assert(game_get_handle_token(handle) == game_get_chunk_token(chunk));
+
+        ChunkJob job = chunk->job;
+        chunk->job   = CHUNK_JOB_NONE;
+        if(job == CHUNK_JOB_GENERATE) {
+            game_chunk_generated(chunk);
+        } else {
+            assert(job == CHUNK_JOB_MESH);
+            game_chunk_meshed(chunk);
+        }
+    }
+}
+
+static void game_reload_chunks(void) {
+    while(!list_is_empty(&g.loaded_chunks_list)) {
+        Chunk *chunk = (Chunk *)list_get_top(&g.loaded_chunks_list);
+        game_chunk_unload(chunk);
+    }
+    g.load_requests_dirty = true;
+}
+
+// NOTE: Move the staging mesh to the vertex arena, a remeshed chunk gives its old range back first
+static void game_chunk_upload(Chunk *chunk) {
+    if(chunk->vertex_count > 0) {
+        gpu_arena_free(&g.vertex_arena, chunk->vertex_offset, chunk->vertex_count);
+        chunk->vertex_count = 0;
+    }
+    if(chunk->geometry_count > 0) {
+        chunk->vertex_offset = gpu_arena_alloc(&g.vertex_arena, chunk->geometry_count);
+        chunk->vertex_count  = chunk->geometry_count;
+        // NOTE: The mesh job wrote the start of the mesh (or all of it) in the mapped slice and the
+        // gpu copies that part over, the rest is uploaded from the mesh pool
+        u32 staged_count = chunk->geometry == chunk->staging ? chunk->geometry_count
+                                                             : chunk->staged_count;
+        if(staged_count > 0) {
+            gpu_staging_copy_to_arena(&g.staging_ring, (u32)chunk->staging_slice, &g.vertex_arena,
+                                      chunk->vertex_offset, staged_count);
+            g.upload_staged_count += 1;
+        }
+        if(staged_count < chunk->geometry_count) {
+            gpu_arena_upload(&g.vertex_arena, chunk->vertex_offset + staged_count, chunk->geometry,
+                             chunk->geometry_count - staged_count);
+        }
+    }
+
+    f32 origin[2] = {chunk->x * VOXEL_DIM * CHUNK_X, chunk->z * VOXEL_DIM * CHUNK_Z};
+    u32 slot      = game_get_chunk_slot(chunk);
+    gpu_update_texture_buffer(g.chunk_origins_buffer, slot * sizeof(origin), origin,
+                              sizeof(origin));
+
+    // NOTE: The gpu has its own copy now, give the staging memory back
+    chunk_release_geometry(chunk);
+    game_chunk_release_staging(chunk);
+
+    game_set_chunk_state(chunk, CHUNK_STATE_UPLOADED);
+}
+
+static int game_compare_uploads(const void *a, const void *b) {
+    f32 distance_a = ((ChunkUpload *)a)->distance;
+    f32 distance_b = ((ChunkUpload *)b)->distance;
+    return (distance_a > distance_b) - (distance_a < distance_b);
+}
+
+// NOTE: Upload the integrated meshes closest to the camera first until the frame budget runs out,
+// the rest keep their staging mesh (and the chunk its old range) until the next frames
+static void game_upload_chunks(void) {
+    V3 camera_pos = v3(g.camera.pos.x / (CHUNK_X * VOXEL_DIM), 0,
+                       g.camera.pos.z / (CHUNK_Z * VOXEL_DIM));
+
+    u32 upload_count      = 0;
+    ChunkNode *chunk_node = list_get_top(&g.loaded_chunks_list);
+    while(!list_is_end(&g.loaded_chunks_list, chunk_node)) {
+        Chunk *chunk = (Chunk *)chunk_node;
+        if(chunk->job == CHUNK_JOB_NONE && game_get_chunk_state(chunk) == CHUNK_STATE_MESHED) {
+            V3 center           = v3((f32)chunk->x + 0.5f, 0, (f32)chunk->z + 0.5f);
+            ChunkUpload *upload = g.uploads + upload_count++;
+            upload->chunk       = chunk;
+            upload->distance    = v3_length(v3_sub(center, camera_pos));
+        }
+        chunk_node = chunk_node->next;
+    }
+    qsort(g.uploads, upload_count, sizeof(ChunkUpload), game_compare_uploads);
+
+    g.upload_count          = 0;
+    g.upload_staged_count   = 0;
+    g.upload_bytes          = 0;
+    g.upload_latency_max_ms = 0;
+
+    u64 now              = SDL_GetPerformanceCounter();
+    f64 ticks_to_ms      = 1000.0 / (f64)SDL_GetPerformanceFrequency();
+    f64 total_latency_ms = 0;
+    for(u32 i = 0; i < upload_count; ++i) {
+        Chunk *chunk = g.uploads[i].chunk;
+        u32 size     = chunk->geometry_count * sizeof(Vertex);
+        if(g.upload_count > 0 && g.upload_bytes + size > GAME_UPLOAD_BUDGET) {
+            break;
+        }
+
+        f32 latency_ms = (f32)((f64)(now - chunk->meshed_ticks) * ticks_to_ms);
+        total_latency_ms += latency_ms;
+        if(latency_ms > g.upload_latency_max_ms) {
+            g.upload_latency_max_ms = latency_ms;
+        }
+
+        game_chunk_upload(chunk);
+        g.upload_count += 1;
+        g.upload_bytes += size;
+    }
+
+    g.uploads_pending           = upload_count - g.upload_count;
+    g.upload_latency_average_ms =
+        g.upload_count ? (f32)(total_latency_ms / (f64)g.upload_count) : 0.0f;
+}
+
+static M4 game_get_view(void) {
+    return m4_lookat2(g.camera.pos, v3_add(g.camera.pos, g.camera.target), g.camera.up);
+}
+
+static b32 game_chunk_in_window(s32 x, s32 z, s32 center_x, s32 center_z) {
+    return x >= center_x - MAX_CHUNKS_X / 2 && x <= center_x + MAX_CHUNKS_X / 2 &&
+           z >= center_z - MAX_CHUNKS_Y / 2 && z <= center_z + MAX_CHUNKS_Y / 2;
+}
+
+static void game_load_requests_sift_down(u32 index) {
+    ChunkLoadRequest *requests = g.load_requests;
+    for(;;) {
+        u32 smallest = index;
+        u32 left     = index * 2 + 1;
+        u32 right    = index * 2 + 2;
+        if(left < g.load_request_count && requests[left].priority < requests[smallest].priority)
+            smallest = left;
+        if(right < g.load_request_count && requests[right].priority < requests[smallest].priority)
+            smallest = right;
+        if(smallest == index) {
+            break;
+        }
+        ChunkLoadRequest temp = requests[index];
+        requests[index]       = requests[smallest];
+        requests[smallest]    = temp;
+        index                 = smallest;
+    }
+}
+
+static ChunkLoadRequest game_load_requests_pop(void) {
+    ChunkLoadRequest result = g.load_requests[0];
+    g.load_request_count -= 1;
+    g.load_requests[0] = g.load_requests[g.load_request_count];
+    game_load_requests_sift_down(0);
+    return result;
+}
+
+// NOTE: Queue every missing chunk of the window, called when the camera enters a new chunk
+static void game_build_load_requests(s32 center_x, s32 center_z) {
+    g.load_request_count = 0;
+    for(s32 x = center_x - MAX_CHUNKS_X / 2; x <= center_x + MAX_CHUNKS_X / 2; ++x) {
+        for(s32 z = center_z - MAX_CHUNKS_Y / 2; z <= center_z + MAX_CHUNKS_Y / 2; ++z) {
+            if(!game_get_chunk(x, z)) {
+                ChunkLoadRequest *request = g.load_requests + g.load_request_count++;
+                request->x                = x;
+                request->z                = z;
+                request->priority         = 0;
+            }
+        }
+    }
+    g.load_center_x       = center_x;
+    g.load_center_z       = center_z;
+    g.load_requests_dirty = false;
+}
+
+// NOTE: World box of the voxels of chunk (x, z) from min_y to max_y, the shader draws every voxel
+// half a voxel down from its coordinates so the box moves the same way
+static void game_get_chunk_box(s32 x, s32 z, s32 min_y, s32 max_y, V3 *min, V3 *max) {
+    f32 offset = -0.5f * VOXEL_DIM;
+    *min       = v3(x * CHUNK_X * VOXEL_DIM + offset, min_y * VOXEL_DIM + offset,
+                    z * CHUNK_Z * VOXEL_DIM + offset);
+    *max       = v3_add(*min, v3(CHUNK_X * VOXEL_DIM, (max_y - min_y + 1) * VOXEL_DIM,
+                                 CHUNK_Z * VOXEL_DIM));
+}
+
+// NOTE: Key the pending requests by their distance to the camera, chunks outside the view
+// frustum go after the visible ones around the same distance. Requests that fell outside of the
+// window or are already loaded are dropped
+static void game_prioritize_load_requests(void) {
+    Frustum frustum = frustum_from_m4(m4_mul(g.proj, game_get_view()));
+    V3 camera_pos   = v3(g.camera.pos.x / (CHUNK_X * VOXEL_DIM), 0,
+                         g.camera.pos.z / (CHUNK_Z * VOXEL_DIM));
+
+    for(u32 i = 0; i < g.load_request_count;) {
+        ChunkLoadRequest *request = g.load_requests + i;
+        if(!game_chunk_in_window(request->x, request->z, g.load_center_x, g.load_center_z) ||
+           game_get_chunk(request->x, request->z)) {
+            *request = g.load_requests[--g.load_request_count];
+            continue;
+        }
+
+        V3 center    = v3((f32)request->x + 0.5f, 0, (f32)request->z + 0.5f);
+        f32 priority = v3_length(v3_sub(center, camera_pos));
+
+        V3 min, max;
+        game_get_chunk_box(request->x, request->z, 0, CHUNK_Y - 1, &min, &max);
+        if(!frustum_intersect_aabb(&frustum, min, max)) {
+            priority += GAME_CHUNK_OUT_OF_VIEW_PENALTY;
+        }
+        request->priority = priority;
+        ++i;
+    }
+
+    for(s32 i = (s32)g.load_request_count / 2 - 1; i >= 0; --i) {
+        game_load_requests_sift_down((u32)i);
+    }
 }
 
 void game_initialize(u32 w, u32 h) {
 
     voxel_block_map_initialize();
-    job_system_initialize();
+    chunk_set_mesher(CHUNK_MESHER_GREEDY);
+    job_system_initialize(MAX_WORKER_THREADS);
 
     game_allocate_chunk_buffer(&g);
     game_setup_buffer_freelist(&g);
-    game_setup_hash_chunk_table(&g);
+    game_setup_chunk_map(&g);
+    game_setup_evict_buckets(&g);
+    game_setup_completion_queue(&g);
+    game_setup_vertex_arena(&g);
 
     camera_initialize(
         &g.camera,
@@ -173,51 +933,93 @@ void game_initialize(u32 w, u32 h) {
     SDL_Surface *atlas = SDL_LoadBMP("res/texture.bmp");
     g.texture          = gpu_load_texture(atlas->pixels, atlas->w, atlas->h);
 
-    glUseProgram(g.program);
+    gpu_use_program(g.program);
 
     // NOTE: Setup perspective projection
     f32 aspect = (f32)w / (f32)h;
-    M4 proj    = m4_perspective2(to_rad(80), aspect, 0.1f, 1000.0f);
-    gpu_load_m4_uniform(g.program, "proj", proj);
+    g.proj     = m4_perspective2(to_rad(80), aspect, 0.1f, 1000.0f);
+    gpu_load_m4_uniform(g.program, "proj", g.proj);
+    gpu_load_s32_uniform(g.program, "chunkOrigins", 1);
+
+    g.load_requests_dirty = true;
 }
 
 void game_terminate(void) {
     job_system_terminate();
+    free(g.completed_chunks.handles);
+    free(g.uploads);
+    free(g.draw_firsts);
+    free(g.draw_counts);
+    gpu_staging_terminate(&g.staging_ring);
+    gpu_arena_terminate(&g.vertex_arena);
+#if !GAME_USE_CHUNK_GRID
+    chunk_map_terminate(&g.chunk_map);
+#endif
+    mesh_pool_terminate();
 }
 
 void game_update(f32 dt) {
 
     camera_update(&g.camera, dt);
 
+    // NOTE: Switch between chunk meshers and rebuild the loaded chunks with the new one
+    if(os_key_just_down(SDL_SCANCODE_G)) {
+        chunk_set_mesher((chunk_get_mesher() + 1) % CHUNK_MESHER_COUNT);
+        game_reload_chunks();
+    }
+
+    game_update_job_rates(dt);
+    if(os_key_just_down(SDL_SCANCODE_P)) {
+        game_print_chunk_states();
+    }
+
     s32 current_chunk_x = (s32)(g.camera.pos.x / CHUNK_X);
     s32 current_chunk_z = (s32)(g.camera.pos.z / CHUNK_Z);
 
-    job_queue_begin();
+    // NOTE: Chunks are generated in the background, the frame never waits for them
+    game_integrate_completed_chunks();
+    game_dispatch_remeshes();
 
-    for(s32 x = current_chunk_x - MAX_CHUNKS_X / 2; x <= current_chunk_x + MAX_CHUNKS_X / 2; ++x) {
-        for(s32 z = current_chunk_z - MAX_CHUNKS_Y / 2; z <= current_chunk_z + MAX_CHUNKS_Y / 2;
-            ++z) {
-            if(!game_chunk_is_loaded(x, z)) {
-                game_chunk_load(x, z);
-            }
-        }
+    if(current_chunk_x != g.evict_center_x || current_chunk_z != g.evict_center_z) {
+        game_update_evict_center(current_chunk_x, current_chunk_z);
     }
 
-    job_queue_end();
+    if(g.load_requests_dirty || current_chunk_x != g.load_center_x ||
+       current_chunk_z != g.load_center_z) {
+        game_build_load_requests(current_chunk_x, current_chunk_z);
+    }
+    game_prioritize_load_requests();
+
+    while(g.chunks_in_flight < GAME_MAX_CHUNKS_IN_FLIGHT && g.load_request_count > 0) {
+        ChunkLoadRequest request = game_load_requests_pop();
+        if(!game_chunk_load(request.x, request.z)) {
+            // NOTE: Every chunk out of the window is owned by a job, try again next frame
+            g.load_requests_dirty = true;
+            break;
+        }
+    }
 }
 
 void game_render(void) {
 
-    glClearColor(0.3f, 0.65f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    gpu_begin_frame();
+    gpu_clear(0.3f, 0.65f, 1.0f);
 
-    glUseProgram(g.program);
-    glBindTexture(GL_TEXTURE_2D, g.texture);
+    // NOTE: The state cache skips the binds that did not change since the last frame
+    gpu_use_program(g.program);
+    gpu_bind_texture(0, GPU_TEXTURE_2D, g.texture);
+    gpu_bind_texture(1, GPU_TEXTURE_BUFFER, g.chunk_origins_texture);
+
+    game_upload_chunks();
 
     // NOTE: Update camera position
-    M4 view = m4_lookat2(g.camera.pos, v3_add(g.camera.pos, g.camera.target), g.camera.up);
+    M4 view = game_get_view();
     gpu_load_m4_uniform(g.program, "view", view);
 
+    Frustum frustum = frustum_from_m4(m4_mul(g.proj, view));
+    g.chunks_drawn  = 0;
+    g.chunks_culled = 0;
+
     u32 chunk_count             = 0;
     u32 chunk_total_vertex_size = 0;
 
@@ -225,32 +1027,32 @@ void game_render(void) {
     while(!list_is_end(&g.loaded_chunks_list, chunk_node)) {
         Chunk *chunk = (Chunk *)chunk_node;
 
-        if(chunk->just_loaded) {
-            glBindBuffer(GL_ARRAY_BUFFER, chunk->vao);
-            glBufferData(GL_ARRAY_BUFFER, chunk->geometry_count * sizeof(Vertex), chunk->geometry,
-                         GL_DYNAMIC_DRAW);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-            chunk->just_loaded = false;
-        }
-
-        if(chunk->is_loaded) {
-            // NOTE: Setup model matrix
-            f32 pos_x = chunk->x * VOXEL_DIM * CHUNK_X;
-            f32 pos_z = chunk->z * VOXEL_DIM * CHUNK_Z;
-            M4 model  = m4_translate(v3(pos_x, 0, pos_z));
-            gpu_load_m4_uniform(g.program, "model", model);
-
-            glBindVertexArray(chunk->vao);
-            glDrawArrays(GL_TRIANGLES, 0, chunk->geometry_count);
-
-            chunk_count += 1;
-            chunk_total_vertex_size += chunk->geometry_count * sizeof(Vertex);
+        if(chunk->vertex_count > 0) {
+            // NOTE: Skip the chunks outside the view frustum, the box only covers the occupied
+            // voxels so chunks below the camera are culled too
+            V3 min, max;
+            game_get_chunk_box(chunk->x, chunk->z, (s32)chunk->min_y, (s32)chunk->max_y, &min,
+                               &max);
+            if(frustum_intersect_aabb(&frustum, min, max)) {
+                g.draw_firsts[g.chunks_drawn] = (s32)chunk->vertex_offset;
+                g.draw_counts[g.chunks_drawn] = (s32)chunk->vertex_count;
+
+                g.chunks_drawn += 1;
+                chunk_count += 1;
+                chunk_total_vertex_size += chunk->vertex_count * sizeof(Vertex);
+            } else {
+                g.chunks_culled += 1;
+            }
         }
 
         chunk_node = chunk_node->next;
     }
 
+    // NOTE: Every visible chunk in one draw call
+    if(g.chunks_drawn > 0) {
+        gpu_arena_draw(&g.vertex_arena, g.draw_firsts, g.draw_counts, g.chunks_drawn);
+    }
+
     unused(chunk_count);
     unused(chunk_total_vertex_size);
 #if 0
@@ -2,10 +2,71 @@
 #define _GAME_H_
 
 #include "common.h"
+#include "os.h"
 #include "chunk.h"
+#include "chunk_map.h"
+#include "chunk_grid.h"
+#include "job.h"
+
+// NOTE: Structure that finds the loaded chunks, the toroidal chunk grid (1) or the open addressing
+// chunk map (0)
+#ifndef GAME_USE_CHUNK_GRID
+#define GAME_USE_CHUNK_GRID 0
+#endif
 #include "camera.h"
 
-#define GAME_CHUNK_HASH_SIZE (MAX_CHUNKS_X * MAX_CHUNKS_Y * 2) 
+// NOTE: Max number of finished chunks integrated (and uploaded to the gpu) per frame
+#define GAME_CHUNK_INTEGRATE_BUDGET 16
+
+// NOTE: Bytes of meshes uploaded to the gpu per frame, the closest chunks go first. A mesh bigger
+// than the budget is still uploaded when it is the first one of the frame
+#ifndef GAME_UPLOAD_BUDGET
+#define GAME_UPLOAD_BUDGET (1024 * 1024)
+#endif
+
+// NOTE: Cells of the load window around the camera chunk
+#define GAME_CHUNK_WINDOW_SIZE ((MAX_CHUNKS_X + 1) * (MAX_CHUNKS_Y + 1))
+// NOTE: Max number of chunks queued in the job system, new requests wait in the load queue so
+// they can still be reordered when the camera moves
+#define GAME_MAX_CHUNKS_IN_FLIGHT 32
+// NOTE: Distance (in chunks) added to the priority of the chunks outside the view frustum
+#define GAME_CHUNK_OUT_OF_VIEW_PENALTY 8.0f
+
+// NOTE: Loaded chunks are bucketed by their column (x) and by their row (z), the coordinate modulo
+// the bucket count. The chebyshev distance of a chunk to the camera chunk is the distance of its
+// column or of its row, so the farthest chunks are in the farthest buckets and moving the camera
+// does not move any chunk between buckets. Chunks closer than the window radius plus the margin
+// are never evicted, so crossing a chunk border back and forth does not reload them
+#define GAME_CHUNK_EVICT_BUCKET_COUNT 256 // NOTE: Power of two
+#define GAME_CHUNK_EVICT_MARGIN 2
+
+// NOTE: The chunk state word keeps the ChunkState in the low bits and a 16 bit token above, a
+// ChunkHandle is the chunk buffer index in the low 16 bits and the token in the high 16 bits.
+// Jobs get handles instead of pointers so they can tell when their chunk was recycled
+#define GAME_CHUNK_STATE_BITS 8
+#define GAME_CHUNK_TOKEN_MASK 0xffff
+
+typedef u32 ChunkHandle;
+
+typedef struct ChunkUpload {
+    Chunk *chunk;
+    f32 distance;
+} ChunkUpload;
+
+typedef struct ChunkLoadRequest {
+    s32 x, z;
+    f32 priority;
+} ChunkLoadRequest;
+
+// NOTE: Chunks whose generate or mesh job finished, waiting for the main thread. A chunk has one
+// job at a time so the ring never holds more than chunk_buffer_count chunks
+typedef struct ChunkCompletionQueue {
+    SDL_SpinLock lock;
+    ChunkHandle *handles;
+    u32 capacity;
+    u32 first;
+    u32 count;
+} ChunkCompletionQueue;
 
 typedef struct Game {
 
@@ -16,7 +77,64 @@ typedef struct Game {
 
     ChunkNode free_chunks_list;
     ChunkNode loaded_chunks_list;
-    ChunkNode hash_chunks[GAME_CHUNK_HASH_SIZE];
+#if GAME_USE_CHUNK_GRID
+    ChunkGrid chunk_grid;
+#else
+    ChunkMap chunk_map;
+#endif
+
+    ChunkNode evict_columns[GAME_CHUNK_EVICT_BUCKET_COUNT];
+    ChunkNode evict_rows[GAME_CHUNK_EVICT_BUCKET_COUNT];
+    s32 evict_center_x, evict_center_z;
+    // NOTE: The buckets farther than this from the camera chunk are empty
+    s32 evict_distance;
+
+    ChunkCompletionQueue completed_chunks;
+    u32 chunks_in_flight;
+    // NOTE: Loaded chunks waiting to be meshed again with a neighbor that generated late
+    u32 remesh_count;
+
+    // NOTE: Job throughput over the last second, cancelled jobs are the ones whose chunk was
+    // unloaded before they finished
+    JobStats job_stats;
+    f32 job_rates_time;
+    f32 jobs_completed_per_second;
+    f32 jobs_cancelled_per_second;
+
+    // NOTE: Min heap of the missing chunks of the load window, lowest priority loads first
+    ChunkLoadRequest load_requests[GAME_CHUNK_WINDOW_SIZE];
+    u32 load_request_count;
+    s32 load_center_x, load_center_z;
+    b32 load_requests_dirty;
+
+    M4 proj;
+
+    // NOTE: The chunk meshes live in the vertex arena, the vertices find the world position of
+    // their chunk in the origin buffer with the chunk buffer index as the slot
+    GpuArena vertex_arena;
+    GpuStagingRing staging_ring;
+    u32 chunk_origins_buffer;
+    u32 chunk_origins_texture;
+
+    // NOTE: Ranges of the vertex arena drawn with glMultiDrawArrays
+    s32 *draw_firsts;
+    s32 *draw_counts;
+
+    // NOTE: Meshed chunks waiting for the gpu, rebuilt every frame
+    ChunkUpload *uploads;
+
+    // NOTE: Uploads of the last frame, the latency goes from the mesh integration to the upload
+    u32 upload_count;
+    // NOTE: Uploads copied on the gpu from the staging ring, the rest came from the mesh pool
+    u32 upload_staged_count;
+    u32 upload_bytes;
+    u32 uploads_pending;
+    f32 upload_latency_average_ms;
+    f32 upload_latency_max_ms;
+
+    // NOTE: Chunks with a mesh drawn and culled by the view frustum in the last frame
+    u32 chunks_drawn;
+    u32 chunks_culled;
 
     u32 program;
     u32 texture;
@@ -37,4 +155,7 @@ void game_chunk_unload(Chunk *chunk);
 Chunk *game_get_chunk(s32 x, s32 z);
 b32 game_chunk_is_loaded(s32 x, s32 z);
 
+// NOTE: Number of chunks of the chunk buffer in each ChunkState
+void game_get_chunk_state_counts(u32 *counts);
+
 #endif // _GAME_H_
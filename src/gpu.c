@@ -3,83 +3,507 @@
 #include "gpu.h"
 #include "os.h"
 
+// NOTE: ARB_buffer_storage (core in 4.4) is not part of the 3.3 loader, it is loaded by hand
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void(APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data,
+                                               GLbitfield flags);
+static PFNGLBUFFERSTORAGEPROC gpu_glBufferStorage;
+
+// NOTE: Gpu state cache ------------------------------------------------
+
+typedef struct GpuUniform {
+    char name[GPU_MAX_UNIFORM_NAME];
+    s32 location;
+} GpuUniform;
+
+typedef struct GpuProgramInfo {
+    u32 program;
+    GpuUniform uniforms[GPU_MAX_UNIFORMS];
+    u32 uniform_count;
+} GpuProgramInfo;
+
+typedef struct GpuState {
+    u32 program;
+    u32 vertex_array;
+    u32 active_texture_unit;
+    u32 textures[GPU_MAX_TEXTURE_UNITS][GPU_TEXTURE_TARGET_COUNT];
+
+    GpuProgramInfo programs[GPU_MAX_PROGRAMS];
+    u32 program_count;
+
+    GpuFrameStats frame_stats;
+    GpuFrameStats last_frame_stats;
+} GpuState;
+
+static GpuState gpu_state;
+
+static GLenum gpu_texture_targets[GPU_TEXTURE_TARGET_COUNT] = {
+    [GPU_TEXTURE_2D]     = GL_TEXTURE_2D,
+    [GPU_TEXTURE_BUFFER] = GL_TEXTURE_BUFFER,
+};
+
+#define gpu_call(call) (gpu_state.frame_stats.calls += 1, call)
+
+void gpu_begin_frame(void) {
+    gpu_state.last_frame_stats = gpu_state.frame_stats;
+    memset(&gpu_state.frame_stats, 0, sizeof(gpu_state.frame_stats));
+}
+
+GpuFrameStats gpu_get_frame_stats(void) {
+    return gpu_state.last_frame_stats;
+}
+
+void gpu_use_program(u32 program) {
+    if(gpu_state.program == program) {
+        gpu_state.frame_stats.skipped_calls += 1;
+        return;
+    }
+    gpu_call(glUseProgram(program));
+    gpu_state.program = program;
+}
+
+void gpu_bind_vertex_array(u32 vertex_array) {
+    if(gpu_state.vertex_array == vertex_array) {
+        gpu_state.frame_stats.skipped_calls += 1;
+        return;
+    }
+    gpu_call(glBindVertexArray(vertex_array));
+    gpu_state.vertex_array = vertex_array;
+}
+
+void gpu_bind_texture(u32 unit, GpuTextureTarget target, u32 texture) {
+    assert(unit < GPU_MAX_TEXTURE_UNITS);
+    if(gpu_state.textures[unit][target] == texture) {
+        gpu_state.frame_stats.skipped_calls += 1;
+        return;
+    }
+    if(gpu_state.active_texture_unit != unit) {
+        gpu_call(glActiveTexture(GL_TEXTURE0 + unit));
+        gpu_state.active_texture_unit = unit;
+    }
+    gpu_call(glBindTexture(gpu_texture_targets[target], texture));
+    gpu_state.textures[unit][target] = texture;
+}
+
+void gpu_clear(f32 r, f32 g, f32 b) {
+    gpu_call(glClearColor(r, g, b, 1.0f));
+    gpu_call(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+}
+
+void gpu_enable_depth_and_culling(void) {
+    gpu_call(glEnable(GL_DEPTH_TEST));
+    gpu_call(glEnable(GL_CULL_FACE));
+    gpu_call(glCullFace(GL_BACK));
+}
+
+void gpu_set_viewport(s32 x, s32 y, s32 width, s32 height) {
+    gpu_call(glViewport(x, y, width, height));
+}
+
+static GpuProgramInfo *gpu_get_program_info(u32 program) {
+    for(u32 i = 0; i < gpu_state.program_count; ++i) {
+        if(gpu_state.programs[i].program == program) {
+            return gpu_state.programs + i;
+        }
+    }
+    return NULL;
+}
+
+static b32 gpu_cache_uniform(GpuProgramInfo *info, char *name, s32 location) {
+    if(info->uniform_count == GPU_MAX_UNIFORMS) {
+        return false;
+    }
+    assert(strlen(name) < GPU_MAX_UNIFORM_NAME);
+    GpuUniform *uniform = info->uniforms + info->uniform_count++;
+    strcpy(uniform->name, name);
+    uniform->location = location;
+    return true;
+}
+
+// NOTE: Cache the location of every active uniform of a program that was just linked
+static void gpu_reflect_program(u32 program) {
+    assert(gpu_state.program_count < GPU_MAX_PROGRAMS);
+    GpuProgramInfo *info = gpu_state.programs + gpu_state.program_count++;
+    info->program        = program;
+    info->uniform_count  = 0;
+
+    GLint uniform_count = 0;
+    gpu_call(glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniform_count));
+    for(s32 i = 0; i < uniform_count; ++i) {
+        char name[GPU_MAX_UNIFORM_NAME];
+        GLsizei length = 0;
+        GLint size     = 0;
+        GLenum type    = 0;
+        gpu_call(glGetActiveUniform(program, (GLuint)i, GPU_MAX_UNIFORM_NAME, &length, &size, &type,
+                                    name));
+        // NOTE: The name may be cut short, gpu_get_uniform_location asks gl for those uniforms
+        if(length >= GPU_MAX_UNIFORM_NAME - 1) {
+            continue;
+        }
+        // NOTE: Arrays are reported as name[0], they are looked up with the plain name
+        if(length > 3 && strcmp(name + length - 3, "[0]") == 0) {
+            name[length - 3] = '\0';
+        }
+
+        s32 location = gpu_call(glGetUniformLocation(program, name));
+        // NOTE: Uniform blocks members have no location
+        if(location >= 0 && !gpu_cache_uniform(info, name, location)) {
+            printf("Program Error: more than %d uniforms\n", GPU_MAX_UNIFORMS);
+            break;
+        }
+    }
+}
+
+s32 gpu_get_uniform_location(u32 program, char *name) {
+    GpuProgramInfo *info = gpu_get_program_info(program);
+    if(info) {
+        for(u32 j = 0; j < info->uniform_count; ++j) {
+            if(strcmp(info->uniforms[j].name, name) == 0) {
+                return info->uniforms[j].location;
+            }
+        }
+    }
+
+    // NOTE: Not in the cache, ask gl and remember the answer (-1 included, setting a uniform at
+    // location -1 is ignored) when the name fits
+    s32 location = gpu_call(glGetUniformLocation(program, name));
+    if(info && strlen(name) < GPU_MAX_UNIFORM_NAME) {
+        gpu_cache_uniform(info, name, location);
+    }
+    return location;
+}
+
+// ----------------------------------------------------------------------
+
 u32 gpu_load_program(char *vs_path, char *fs_path) {
     File vs_file = os_read_entire_file(vs_path);
     File fs_file = os_read_entire_file(fs_path);
 
     GLint vs_compile = 0;
-    u32 vs_shader    = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vs_shader, 1, (const char **)&vs_file.data, NULL);
-    glCompileShader(vs_shader);
-    glGetShaderiv(vs_shader, GL_COMPILE_STATUS, &vs_compile);
+    u32 vs_shader    = gpu_call(glCreateShader(GL_VERTEX_SHADER));
+    gpu_call(glShaderSource(vs_shader, 1, (const char **)&vs_file.data, NULL));
+    gpu_call(glCompileShader(vs_shader));
+    gpu_call(glGetShaderiv(vs_shader, GL_COMPILE_STATUS, &vs_compile));
     if(vs_compile != GL_TRUE) {
         GLsizei log_length = 0;
         GLchar message[1024];
-        glGetShaderInfoLog(vs_shader, 1024, &log_length, message);
+        gpu_call(glGetShaderInfoLog(vs_shader, 1024, &log_length, message));
         printf("Vertex Shader Error: %s\n", message);
     }
 
     GLint fs_compile = 0;
-    u32 fs_shader    = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fs_shader, 1, (const char **)&fs_file.data, NULL);
-    glCompileShader(fs_shader);
-    glGetShaderiv(fs_shader, GL_COMPILE_STATUS, &fs_compile);
+    u32 fs_shader    = gpu_call(glCreateShader(GL_FRAGMENT_SHADER));
+    gpu_call(glShaderSource(fs_shader, 1, (const char **)&fs_file.data, NULL));
+    gpu_call(glCompileShader(fs_shader));
+    gpu_call(glGetShaderiv(fs_shader, GL_COMPILE_STATUS, &fs_compile));
     if(fs_compile != GL_TRUE) {
         GLsizei log_length = 0;
         GLchar message[1024];
-        glGetShaderInfoLog(fs_shader, 1024, &log_length, message);
+        gpu_call(glGetShaderInfoLog(fs_shader, 1024, &log_length, message));
         printf("Fragment Shader Error: %s\n", message);
     }
 
-    u32 program = glCreateProgram();
+    u32 program = gpu_call(glCreateProgram());
 
-    glAttachShader(program, vs_shader);
-    glAttachShader(program, fs_shader);
+    gpu_call(glAttachShader(program, vs_shader));
+    gpu_call(glAttachShader(program, fs_shader));
     GLint link = 0;
-    glLinkProgram(program);
-    glGetProgramiv(program, GL_LINK_STATUS, &link);
+    gpu_call(glLinkProgram(program));
+    gpu_call(glGetProgramiv(program, GL_LINK_STATUS, &link));
     if(link != GL_TRUE) {
         GLsizei log_length = 0;
         GLchar message[1024];
-        glGetProgramInfoLog(vs_shader, 1024, &log_length, message);
+        gpu_call(glGetProgramInfoLog(vs_shader, 1024, &log_length, message));
         printf("Program Error: %s\n", message);
     }
 
-    glDeleteShader(vs_shader);
-    glDeleteShader(fs_shader);
+    gpu_call(glDeleteShader(vs_shader));
+    gpu_call(glDeleteShader(fs_shader));
 
     os_free_entire_file(&vs_file);
     os_free_entire_file(&fs_file);
 
+    gpu_reflect_program(program);
+
     return program;
 }
 
-u32 gpu_load_buffer(Vertex *data, u64 size) {
-    u32 vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+// NOTE: Vertex arena ---------------------------------------------------
+
+static inline u32 gpu_arena_round_count(u32 count) {
+    return (count + GPU_ARENA_GRANULARITY - 1) & ~(GPU_ARENA_GRANULARITY - 1);
+}
+
+static void gpu_arena_insert_free_range(GpuArena *arena, u32 index, u32 offset, u32 count) {
+    if(arena->free_range_count == arena->free_range_capacity) {
+        u32 capacity               = arena->free_range_capacity * 2;
+        arena->free_range_capacity = capacity ? capacity : 64;
+        arena->free_ranges         = (GpuArenaRange *)realloc(
+            arena->free_ranges, sizeof(GpuArenaRange) * arena->free_range_capacity);
+    }
+    GpuArenaRange *ranges = arena->free_ranges;
+    memmove(ranges + index + 1, ranges + index,
+            sizeof(GpuArenaRange) * (arena->free_range_count - index));
+    ranges[index].offset = offset;
+    ranges[index].count  = count;
+    arena->free_range_count += 1;
+}
+
+static void gpu_arena_remove_free_range(GpuArena *arena, u32 index) {
+    GpuArenaRange *ranges = arena->free_ranges;
+    memmove(ranges + index, ranges + index + 1,
+            sizeof(GpuArenaRange) * (arena->free_range_count - index - 1));
+    arena->free_range_count -= 1;
+}
+
+// NOTE: Give a range back to the free list, merged with the free ranges right before and after it
+static void gpu_arena_release_range(GpuArena *arena, u32 offset, u32 count) {
+    GpuArenaRange *ranges = arena->free_ranges;
+
+    // NOTE: First free range after the released one
+    u32 index = 0;
+    u32 end   = arena->free_range_count;
+    while(index < end) {
+        u32 middle = (index + end) / 2;
+        if(ranges[middle].offset < offset) {
+            index = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+
+    b32 merge_prev = index > 0 && ranges[index - 1].offset + ranges[index - 1].count == offset;
+    b32 merge_next = index < arena->free_range_count && offset + count == ranges[index].offset;
+    if(merge_prev && merge_next) {
+        ranges[index - 1].count += count + ranges[index].count;
+        gpu_arena_remove_free_range(arena, index);
+    } else if(merge_prev) {
+        ranges[index - 1].count += count;
+    } else if(merge_next) {
+        ranges[index].offset = offset;
+        ranges[index].count += count;
+    } else {
+        gpu_arena_insert_free_range(arena, index, offset, count);
+    }
+}
+
+static void gpu_arena_bind_vbo(GpuArena *arena) {
+    gpu_bind_vertex_array(arena->vao);
+    gpu_call(glBindBuffer(GL_ARRAY_BUFFER, arena->vbo));
+
+    gpu_call(glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(Vertex),
+                                    offset_of(Vertex, pos_face)));
+    gpu_call(glEnableVertexAttribArray(0));
+
+    gpu_bind_vertex_array(0);
+    gpu_call(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+// NOTE: Move the meshes to a bigger buffer, the offsets of the allocated ranges do not change
+static void gpu_arena_grow(GpuArena *arena, u32 min_capacity) {
+    u32 old_capacity = arena->capacity;
+    u32 capacity     = old_capacity * 2;
+    while(capacity < min_capacity) {
+        capacity *= 2;
+    }
 
     u32 vbo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW);
+    gpu_call(glGenBuffers(1, &vbo));
+    gpu_call(glBindBuffer(GL_COPY_WRITE_BUFFER, vbo));
+    gpu_call(glBufferData(GL_COPY_WRITE_BUFFER, (u64)capacity * sizeof(Vertex), NULL,
+                          GL_DYNAMIC_DRAW));
+    gpu_call(glBindBuffer(GL_COPY_READ_BUFFER, arena->vbo));
+    gpu_call(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                                 (u64)old_capacity * sizeof(Vertex)));
+    gpu_call(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    gpu_call(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    gpu_call(glDeleteBuffers(1, &arena->vbo));
+
+    arena->vbo      = vbo;
+    arena->capacity = capacity;
+    gpu_arena_bind_vbo(arena);
+
+    gpu_arena_release_range(arena, old_capacity, capacity - old_capacity);
+}
+
+void gpu_arena_initialize(GpuArena *arena, u32 capacity) {
+    memset(arena, 0, sizeof(*arena));
+    arena->capacity = gpu_arena_round_count(capacity);
+
+    gpu_call(glGenVertexArrays(1, &arena->vao));
+    gpu_call(glGenBuffers(1, &arena->vbo));
+    gpu_call(glBindBuffer(GL_ARRAY_BUFFER, arena->vbo));
+    gpu_call(glBufferData(GL_ARRAY_BUFFER, (u64)arena->capacity * sizeof(Vertex), NULL,
+                          GL_DYNAMIC_DRAW));
+    gpu_arena_bind_vbo(arena);
+
+    gpu_arena_release_range(arena, 0, arena->capacity);
+}
+
+void gpu_arena_terminate(GpuArena *arena) {
+    if(gpu_state.vertex_array == arena->vao) {
+        gpu_bind_vertex_array(0);
+    }
+    gpu_call(glDeleteBuffers(1, &arena->vbo));
+    gpu_call(glDeleteVertexArrays(1, &arena->vao));
+    free(arena->free_ranges);
+    memset(arena, 0, sizeof(*arena));
+}
+
+u32 gpu_arena_alloc(GpuArena *arena, u32 count) {
+    assert(count > 0);
+    count = gpu_arena_round_count(count);
+    for(;;) {
+        for(u32 i = 0; i < arena->free_range_count; ++i) {
+            GpuArenaRange *range = arena->free_ranges + i;
+            if(range->count >= count) {
+                u32 offset = range->offset;
+                range->offset += count;
+                range->count -= count;
+                if(range->count == 0) {
+                    gpu_arena_remove_free_range(arena, i);
+                }
+                arena->used += count;
+                return offset;
+            }
+        }
+        gpu_arena_grow(arena, arena->capacity + count);
+    }
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex), offset_of(Vertex, pos));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_TRUE, sizeof(Vertex), offset_of(Vertex, nor));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_TRUE, sizeof(Vertex), offset_of(Vertex, uvs));
-    glEnableVertexAttribArray(2);
+void gpu_arena_free(GpuArena *arena, u32 offset, u32 count) {
+    assert(count > 0);
+    count = gpu_arena_round_count(count);
+    assert(offset + count <= arena->capacity && arena->used >= count);
+    arena->used -= count;
+    gpu_arena_release_range(arena, offset, count);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void gpu_arena_upload(GpuArena *arena, u32 offset, Vertex *vertices, u32 count) {
+    gpu_call(glBindBuffer(GL_ARRAY_BUFFER, arena->vbo));
+    gpu_call(glBufferSubData(GL_ARRAY_BUFFER, (u64)offset * sizeof(Vertex),
+                             (u64)count * sizeof(Vertex), vertices));
+    gpu_call(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
 
-    return vao;
+void gpu_arena_draw(GpuArena *arena, s32 *firsts, s32 *counts, u32 draw_count) {
+    gpu_bind_vertex_array(arena->vao);
+    gpu_call(glMultiDrawArrays(GL_TRIANGLES, firsts, counts, (GLsizei)draw_count));
 }
 
+// ----------------------------------------------------------------------
+
+// NOTE: Staging ring ---------------------------------------------------
+
+b32 gpu_staging_initialize(GpuStagingRing *ring) {
+    memset(ring, 0, sizeof(*ring));
+    if(!SDL_GL_ExtensionSupported("GL_ARB_buffer_storage")) {
+        return false;
+    }
+    // NOTE: ISO C has no cast from void * to a function pointer, copy the bits instead
+    void *proc = SDL_GL_GetProcAddress("glBufferStorage");
+    memcpy(&gpu_glBufferStorage, &proc, sizeof(gpu_glBufferStorage));
+    if(!gpu_glBufferStorage) {
+        return false;
+    }
+
+    u64 size         = (u64)GPU_STAGING_SLICE_SIZE * GPU_STAGING_SLICE_COUNT;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    gpu_call(glGenBuffers(1, &ring->buffer));
+    gpu_call(glBindBuffer(GL_COPY_READ_BUFFER, ring->buffer));
+    gpu_call(gpu_glBufferStorage(GL_COPY_READ_BUFFER, size, NULL, flags));
+    ring->vertices = (Vertex *)gpu_call(glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, flags));
+    gpu_call(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+
+    if(!ring->vertices) {
+        gpu_call(glDeleteBuffers(1, &ring->buffer));
+        ring->buffer = 0;
+        return false;
+    }
+    return true;
+}
+
+void gpu_staging_terminate(GpuStagingRing *ring) {
+    if(!ring->vertices) {
+        return;
+    }
+    for(u32 slice = 0; slice < GPU_STAGING_SLICE_COUNT; ++slice) {
+        if(ring->slice_fences[slice]) {
+            gpu_call(glDeleteSync((GLsync)ring->slice_fences[slice]));
+        }
+    }
+    gpu_call(glBindBuffer(GL_COPY_READ_BUFFER, ring->buffer));
+    gpu_call(glUnmapBuffer(GL_COPY_READ_BUFFER));
+    gpu_call(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    gpu_call(glDeleteBuffers(1, &ring->buffer));
+    memset(ring, 0, sizeof(*ring));
+}
+
+// NOTE: First free slice after the cursor, the fences are polled and never waited on
+s32 gpu_staging_acquire(GpuStagingRing *ring) {
+    if(!ring->vertices) {
+        return -1;
+    }
+    for(u32 i = 0; i < GPU_STAGING_SLICE_COUNT; ++i) {
+        u32 slice = (ring->cursor + i) % GPU_STAGING_SLICE_COUNT;
+        if(ring->slice_states[slice] == GPU_STAGING_SLICE_FENCED) {
+            GLsync fence  = (GLsync)ring->slice_fences[slice];
+            GLenum result = gpu_call(glClientWaitSync(fence, 0, 0));
+            if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+                continue;
+            }
+            gpu_call(glDeleteSync(fence));
+            ring->slice_fences[slice] = NULL;
+            ring->slice_states[slice] = GPU_STAGING_SLICE_FREE;
+        }
+        if(ring->slice_states[slice] == GPU_STAGING_SLICE_FREE) {
+            ring->slice_states[slice] = GPU_STAGING_SLICE_ACQUIRED;
+            ring->cursor              = (slice + 1) % GPU_STAGING_SLICE_COUNT;
+            return (s32)slice;
+        }
+    }
+    return -1;
+}
+
+Vertex *gpu_staging_get_slice(GpuStagingRing *ring, u32 slice) {
+    assert(slice < GPU_STAGING_SLICE_COUNT);
+    return ring->vertices + slice * GPU_STAGING_SLICE_VERTICES;
+}
+
+void gpu_staging_copy_to_arena(GpuStagingRing *ring, u32 slice, GpuArena *arena, u32 offset,
+                               u32 count) {
+    assert(ring->slice_states[slice] == GPU_STAGING_SLICE_ACQUIRED && !ring->slice_fences[slice]);
+    assert(count <= GPU_STAGING_SLICE_VERTICES);
+    gpu_call(glBindBuffer(GL_COPY_READ_BUFFER, ring->buffer));
+    gpu_call(glBindBuffer(GL_COPY_WRITE_BUFFER, arena->vbo));
+    gpu_call(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                 (u64)slice * GPU_STAGING_SLICE_SIZE, (u64)offset * sizeof(Vertex),
+                                 (u64)count * sizeof(Vertex)));
+    gpu_call(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    gpu_call(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    ring->slice_fences[slice] = gpu_call(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+// NOTE: A slice that was copied stays fenced until the gpu is done reading it
+void gpu_staging_release(GpuStagingRing *ring, u32 slice) {
+    assert(ring->slice_states[slice] == GPU_STAGING_SLICE_ACQUIRED);
+    ring->slice_states[slice] =
+        ring->slice_fences[slice] ? GPU_STAGING_SLICE_FENCED : GPU_STAGING_SLICE_FREE;
+}
+
+// ----------------------------------------------------------------------
+
 void gpu_load_m4_uniform(u32 program, char *name, M4 m) {
-    s32 location = glGetUniformLocation(program, (const GLchar *)name);
-    glUniformMatrix4fv(location, 1, GL_TRUE, (const GLfloat *)m.m);
+    s32 location = gpu_get_uniform_location(program, name);
+    gpu_call(glUniformMatrix4fv(location, 1, GL_TRUE, (const GLfloat *)m.m));
+}
+
+void gpu_load_s32_uniform(u32 program, char *name, s32 value) {
+    s32 location = gpu_get_uniform_location(program, name);
+    gpu_call(glUniform1i(location, value));
 }
 
 static inline void *gpu_generate_mipmap(void *pixels, u32 w, u32 h, u32 level, u32 *out_w,
@@ -145,28 +569,50 @@ static inline void *gpu_generate_mipmap(void *pixels, u32 w, u32 h, u32 level, u
 
 u32 gpu_load_texture(void *pixels, u32 w, u32 h) {
     u32 texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    gpu_call(glGenTextures(1, &texture));
+    gpu_bind_texture(0, GPU_TEXTURE_2D, texture);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gpu_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR));
+    gpu_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 5);
+    gpu_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 5));
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    gpu_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER));
+    gpu_call(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER));
 
     for(u32 level = 0; level <= 5; ++level) {
         u32 mipmap_w, mipmap_h;
         void *mipmap = gpu_generate_mipmap(pixels, w, h, level, &mipmap_w, &mipmap_h);
-        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, mipmap_w, mipmap_h, 0, GL_BGRA,
-                     GL_UNSIGNED_BYTE, mipmap);
+        gpu_call(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, mipmap_w, mipmap_h, 0, GL_BGRA,
+                              GL_UNSIGNED_BYTE, mipmap));
         free(mipmap);
     }
 
     // glGenerateMipmap(GL_TEXTURE_2D);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    gpu_bind_texture(0, GPU_TEXTURE_2D, 0);
 
     return texture;
 }
+
+u32 gpu_load_texture_buffer(u32 *buffer, u32 texel_count) {
+    gpu_call(glGenBuffers(1, buffer));
+    gpu_call(glBindBuffer(GL_TEXTURE_BUFFER, *buffer));
+    gpu_call(glBufferData(GL_TEXTURE_BUFFER, texel_count * sizeof(f32) * 2, NULL,
+                          GL_DYNAMIC_DRAW));
+    gpu_call(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+    u32 texture;
+    gpu_call(glGenTextures(1, &texture));
+    gpu_bind_texture(0, GPU_TEXTURE_BUFFER, texture);
+    gpu_call(glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, *buffer));
+    gpu_bind_texture(0, GPU_TEXTURE_BUFFER, 0);
+
+    return texture;
+}
+
+void gpu_update_texture_buffer(u32 buffer, u32 offset, void *data, u32 size) {
+    gpu_call(glBindBuffer(GL_TEXTURE_BUFFER, buffer));
+    gpu_call(glBufferSubData(GL_TEXTURE_BUFFER, offset, size, data));
+    gpu_call(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+}
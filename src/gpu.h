@@ -3,15 +3,136 @@
 
 #include "algebra.h"
 
+// NOTE: Packed chunk vertex (8 bytes). The position is a voxel corner in chunk local space, the
+// normal is one of the six faces, the tile is the atlas index and the slot is the index of the
+// chunk origin in the origin buffer, the shader unpacks everything
+//   pos_face: x (5 bits) | y (9 bits) | z (5 bits) | face (3 bits)
+//   tile:     tile (8 bits) | slot (12 bits) | unused
 typedef struct Vertex {
-    V3 pos;
-    V3 nor;
-    V2 uvs;
+    u32 pos_face;
+    u32 tile;
 } Vertex;
 
+#define VERTEX_X_SHIFT 0
+#define VERTEX_Y_SHIFT 5
+#define VERTEX_Z_SHIFT 14
+#define VERTEX_FACE_SHIFT 19
+#define VERTEX_SLOT_SHIFT 8
+#define VERTEX_MAX_SLOTS 0x1000
+
+static inline Vertex vertex_pack(u32 x, u32 y, u32 z, u32 face, u32 tile) {
+    assert(x <= 0x1f && y <= 0x1ff && z <= 0x1f && face <= 0x7 && tile <= 0xff);
+    Vertex result;
+    result.pos_face = (x << VERTEX_X_SHIFT) | (y << VERTEX_Y_SHIFT) | (z << VERTEX_Z_SHIFT) |
+                      (face << VERTEX_FACE_SHIFT);
+    result.tile     = tile;
+    return result;
+}
+
+// NOTE: Vertex arena, the meshes of every chunk live in one vertex buffer so they can be drawn
+// with a single glMultiDrawArrays. Ranges (in vertices, rounded up to GPU_ARENA_GRANULARITY) are
+// handed out first fit from a free list sorted by offset and freed ranges are merged with the
+// free ranges around them. The buffer doubles its size when no free range is big enough
+
+#define GPU_ARENA_INITIAL_CAPACITY (4 * 1024 * 1024) // NOTE: 32MB
+#define GPU_ARENA_GRANULARITY 64
+
+typedef struct GpuArenaRange {
+    u32 offset;
+    u32 count;
+} GpuArenaRange;
+
+typedef struct GpuArena {
+    u32 vao;
+    u32 vbo;
+    u32 capacity;
+    u32 used;
+
+    GpuArenaRange *free_ranges;
+    u32 free_range_count;
+    u32 free_range_capacity;
+} GpuArena;
+
+void gpu_arena_initialize(GpuArena *arena, u32 capacity);
+void gpu_arena_terminate(GpuArena *arena);
+u32 gpu_arena_alloc(GpuArena *arena, u32 count);
+void gpu_arena_free(GpuArena *arena, u32 offset, u32 count);
+void gpu_arena_upload(GpuArena *arena, u32 offset, Vertex *vertices, u32 count);
+
+void gpu_arena_draw(GpuArena *arena, s32 *firsts, s32 *counts, u32 draw_count);
+
+// NOTE: Staging ring, a persistently mapped buffer (ARB_buffer_storage) cut in fixed size slices.
+// The main thread hands a slice to a mesh job, the job writes the mesh straight into it and the
+// upload is a gpu side copy into the vertex arena. A slice is reused once the fence of its copy
+// signals, no free slice or no ARB_buffer_storage means the mesh is uploaded from the cpu
+
+#define GPU_STAGING_SLICE_SIZE (256 * 1024)
+#define GPU_STAGING_SLICE_VERTICES (GPU_STAGING_SLICE_SIZE / sizeof(Vertex))
+#define GPU_STAGING_SLICE_COUNT 64
+
+typedef enum GpuStagingSliceState {
+    GPU_STAGING_SLICE_FREE,
+    GPU_STAGING_SLICE_ACQUIRED,
+    GPU_STAGING_SLICE_FENCED,
+} GpuStagingSliceState;
+
+typedef struct GpuStagingRing {
+    u32 buffer;
+    // NOTE: NULL when the buffer storage is not supported
+    Vertex *vertices;
+    u32 cursor;
+
+    u8 slice_states[GPU_STAGING_SLICE_COUNT];
+    void *slice_fences[GPU_STAGING_SLICE_COUNT];
+} GpuStagingRing;
+
+b32 gpu_staging_initialize(GpuStagingRing *ring);
+void gpu_staging_terminate(GpuStagingRing *ring);
+s32 gpu_staging_acquire(GpuStagingRing *ring);
+Vertex *gpu_staging_get_slice(GpuStagingRing *ring, u32 slice);
+void gpu_staging_copy_to_arena(GpuStagingRing *ring, u32 slice, GpuArena *arena, u32 offset,
+                               u32 count);
+void gpu_staging_release(GpuStagingRing *ring, u32 slice);
+
+// NOTE: Every gl call goes through gpu.c so it can be counted. The bound program, vertex array
+// and textures are cached and binding them again does not reach the driver. The uniform
+// locations of a program are read once when it is linked
+
+#define GPU_MAX_PROGRAMS 8
+#define GPU_MAX_UNIFORMS 16
+#define GPU_MAX_UNIFORM_NAME 32
+#define GPU_MAX_TEXTURE_UNITS 4
+
+typedef enum GpuTextureTarget {
+    GPU_TEXTURE_2D,
+    GPU_TEXTURE_BUFFER,
+
+    GPU_TEXTURE_TARGET_COUNT
+} GpuTextureTarget;
+
+// NOTE: Gl calls issued and redundant binds skipped between two gpu_begin_frame
+typedef struct GpuFrameStats {
+    u32 calls;
+    u32 skipped_calls;
+} GpuFrameStats;
+
+void gpu_begin_frame(void);
+GpuFrameStats gpu_get_frame_stats(void);
+
+void gpu_use_program(u32 program);
+void gpu_bind_vertex_array(u32 vertex_array);
+void gpu_bind_texture(u32 unit, GpuTextureTarget target, u32 texture);
+void gpu_clear(f32 r, f32 g, f32 b);
+void gpu_enable_depth_and_culling(void);
+void gpu_set_viewport(s32 x, s32 y, s32 width, s32 height);
+
 u32 gpu_load_program(char *vs_path, char *fs_path);
-u32 gpu_load_buffer(Vertex *data, u64 size);
+s32 gpu_get_uniform_location(u32 program, char *name);
 void gpu_load_m4_uniform(u32 program, char *name, M4 m);
+void gpu_load_s32_uniform(u32 program, char *name, s32 value);
 u32 gpu_load_texture(void *pixels, u32 w, u32 h);
+// NOTE: Buffer texture with two floats per texel, read in the shaders with texelFetch
+u32 gpu_load_texture_buffer(u32 *buffer, u32 texel_count);
+void gpu_update_texture_buffer(u32 buffer, u32 offset, void *data, u32 size);
 
 #endif // _GPU_H_
@@ -1,55 +1,256 @@
 #include "os.h"
 #include "job.h"
 
+#include <string.h>
+
 // NOTE: Multithreading job system --------------------------------------
+//
+// Every thread that runs jobs (the workers and the thread that called job_system_initialize) owns
+// a work-stealing deque. The owner pushes and pops jobs at the bottom of its deque and the other
+// threads steal from the top. Jobs pushed from any other thread, or when a deque is full, go to a
+// growable injection queue protected by a mutex.
+
+#define JOB_CACHE_LINE_SIZE 64
+
+typedef struct JobAtomic {
+    SDL_atomic_t value;
+    u8 padding[JOB_CACHE_LINE_SIZE - sizeof(SDL_atomic_t)];
+} JobAtomic;
+
+typedef struct JobDeque {
+    JobAtomic top;
+    JobAtomic bottom;
+    ThreadJob jobs[JOB_DEQUE_SIZE];
+    // NOTE: Only used by the owner to pick the victims to steal from
+    u32 random_state;
+    u8 padding[JOB_CACHE_LINE_SIZE - sizeof(u32)];
+} JobDeque;
+
+typedef struct JobInjectionQueue {
+    SDL_mutex *mutex;
+    ThreadJob *jobs;
+    u32 capacity;
+    u32 first;
+    JobAtomic count;
+} JobInjectionQueue;
 
 SDL_Thread *thread_pool[MAX_WORKER_THREADS];
+u32 thread_pool_count;
 SDL_sem *semaphore;
+SDL_TLSID worker_tls;
+
+// NOTE: Deque 0 belongs to the thread that initialized the job system
+JobDeque deques[MAX_WORKER_THREADS + 1];
+u32 deque_count;
+JobInjectionQueue injection;
+
+JobAtomic jobs_pushed;
+JobAtomic jobs_done;
+JobAtomic running;
+
+JobAtomic jobs_completed;
+JobAtomic jobs_cancelled;
+
+static JobDeque *job_get_thread_deque(void) {
+    uintptr_t worker = (uintptr_t)SDL_TLSGet(worker_tls);
+    return worker ? deques + (worker - 1) : NULL;
+}
+
+static b32 job_deque_push(JobDeque *deque, ThreadJob job) {
+    s32 bottom = SDL_AtomicGet(&deque->bottom.value);
+    s32 top    = SDL_AtomicGet(&deque->top.value);
+    if(bottom - top >= JOB_DEQUE_SIZE) {
+        return false;
+    }
+    deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)] = job;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&deque->bottom.value, bottom + 1);
+    return true;
+}
+
+static b32 job_deque_pop(JobDeque *deque, ThreadJob *job) {
+    // NOTE: SDL_AtomicAdd is a full barrier, the bottom has to be published before the top is read
+    s32 bottom = SDL_AtomicAdd(&deque->bottom.value, -1) - 1;
+    s32 top    = SDL_AtomicGet(&deque->top.value);
+
+    if(top > bottom) {
+        SDL_AtomicSet(&deque->bottom.value, top);
+        return false;
+    }
+
+    *job = deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)];
+    if(top != bottom) {
+        return true;
+    }
+
+    // NOTE: Last job of the deque, race the thieves for it
+    b32 success = SDL_AtomicCAS(&deque->top.value, top, top + 1);
+    SDL_AtomicSet(&deque->bottom.value, top + 1);
+    return success;
+}
+
+static b32 job_deque_steal(JobDeque *deque, ThreadJob *job) {
+    s32 top    = SDL_AtomicGet(&deque->top.value);
+    s32 bottom = SDL_AtomicGet(&deque->bottom.value);
+    if(top >= bottom) {
+        return false;
+    }
+    *job = deque->jobs[top & (JOB_DEQUE_SIZE - 1)];
+    return SDL_AtomicCAS(&deque->top.value, top, top + 1);
+}
+
+static void job_injection_push(ThreadJob job) {
+    SDL_LockMutex(injection.mutex);
+
+    u32 count = (u32)SDL_AtomicGet(&injection.count.value);
+    if(count == injection.capacity) {
+        u32 capacity    = injection.capacity ? injection.capacity * 2 : JOB_DEQUE_SIZE;
+        ThreadJob *jobs = (ThreadJob *)malloc(sizeof(ThreadJob) * capacity);
+        for(u32 i = 0; i < count; ++i) {
+            jobs[i] = injection.jobs[(injection.first + i) % injection.capacity];
+        }
+        free(injection.jobs);
+        injection.jobs     = jobs;
+        injection.capacity = capacity;
+        injection.first    = 0;
+    }
+
+    injection.jobs[(injection.first + count) % injection.capacity] = job;
+    SDL_AtomicSet(&injection.count.value, count + 1);
+
+    SDL_UnlockMutex(injection.mutex);
+}
+
+static b32 job_injection_pop(ThreadJob *job) {
+    if(SDL_AtomicGet(&injection.count.value) == 0) {
+        return false;
+    }
+
+    b32 success = false;
+    SDL_LockMutex(injection.mutex);
+    s32 count = SDL_AtomicGet(&injection.count.value);
+    if(count > 0) {
+        *job            = injection.jobs[injection.first];
+        injection.first = (injection.first + 1) % injection.capacity;
+        SDL_AtomicSet(&injection.count.value, count - 1);
+        success = true;
+    }
+    SDL_UnlockMutex(injection.mutex);
+
+    return success;
+}
+
+static b32 job_get(JobDeque *deque, ThreadJob *job) {
+    if(deque && job_deque_pop(deque, job)) {
+        return true;
+    }
+    if(job_injection_pop(job)) {
+        return true;
+    }
+
+    // NOTE: Start stealing from a random victim so the thieves do not all hit the same deque
+    u32 start = 0;
+    if(deque) {
+        u32 state           = deque->random_state;
+        state               ^= state << 13;
+        state               ^= state >> 17;
+        state               ^= state << 5;
+        deque->random_state = state;
+        start               = state % deque_count;
+    }
+
+    for(u32 i = 0; i < deque_count; ++i) {
+        JobDeque *victim = deques + ((start + i) % deque_count);
+        if(victim != deque && job_deque_steal(victim, job)) {
+            return true;
+        }
+    }
+
+    return false;
+}
 
-ThreadJob jobs[MAX_THREAD_JOBS];
-SDL_atomic_t jobs_pushed;
-SDL_atomic_t jobs_done;
-SDL_atomic_t next_job;
+static void job_run(ThreadJob *job) {
+    // NOTE: Cancelled jobs still count as done so job_queue_end does not wait for them
+    if(job_is_cancelled(job->handle) || job->run(job->args) == JOB_CANCELLED) {
+        SDL_AtomicIncRef(&jobs_cancelled.value);
+    } else {
+        SDL_AtomicIncRef(&jobs_completed.value);
+    }
+    SDL_AtomicIncRef(&jobs_done.value);
+}
+
+void job_handle_reset(JobHandle *handle) {
+    SDL_AtomicSet(&handle->cancelled, 0);
+}
+
+void job_cancel(JobHandle *handle) {
+    SDL_AtomicSet(&handle->cancelled, 1);
+}
+
+b32 job_is_cancelled(JobHandle *handle) {
+    return handle && SDL_AtomicGet(&handle->cancelled);
+}
+
+JobStats job_get_stats(void) {
+    JobStats stats;
+    stats.completed = (u32)SDL_AtomicGet(&jobs_completed.value);
+    stats.cancelled = (u32)SDL_AtomicGet(&jobs_cancelled.value);
+    return stats;
+}
 
 void job_queue_begin(void) {
-    jobs_pushed.value = 0;
-    jobs_done.value   = 0;
-    next_job.value    = 0;
+    SDL_AtomicSet(&jobs_pushed.value, 0);
+    SDL_AtomicSet(&jobs_done.value, 0);
 }
 
 void job_queue_end(void) {
-    while(jobs_done.value < jobs_pushed.value) {
-        s32 job_index = next_job.value;
-        if(job_index < jobs_pushed.value) {
-            if(SDL_AtomicCAS(&next_job, job_index, job_index + 1)) {
-                ThreadJob *job = jobs + job_index;
-                job->run(job->args);
-                SDL_AtomicIncRef(&jobs_done);
-            }
+    JobDeque *deque = job_get_thread_deque();
+    while(SDL_AtomicGet(&jobs_done.value) < SDL_AtomicGet(&jobs_pushed.value)) {
+        ThreadJob job;
+        if(job_get(deque, &job)) {
+            job_run(&job);
         }
     }
 }
 
 void push_job(ThreadJob job) {
-    jobs[jobs_pushed.value] = job;
-    SDL_CompilerBarrier();
-    SDL_AtomicIncRef(&jobs_pushed);
+    SDL_AtomicIncRef(&jobs_pushed.value);
+
+    JobDeque *deque = job_get_thread_deque();
+    if(!deque || !job_deque_push(deque, job)) {
+        job_injection_push(job);
+    }
     SDL_SemPost(semaphore);
 }
 
+void job_counter_initialize(JobCounter *counter, u32 count, ThreadJob job) {
+    assert(count > 0);
+    counter->job = job;
+    SDL_AtomicSet(&counter->value, (s32)count);
+}
+
+b32 job_counter_decrement(JobCounter *counter) {
+    // NOTE: SDL_AtomicAdd is a full barrier, the writes of every dependency are visible to the job
+    s32 value = SDL_AtomicAdd(&counter->value, -1) - 1;
+    assert(value >= 0);
+    if(value == 0) {
+        push_job(counter->job);
+        return true;
+    }
+    return false;
+}
+
 static int thread_do_jobs(void *data) {
 
-    u8 *memory = (u8 *)data;
-    unused(memory);
-
-    for(;;) {
-        s32 job_index = next_job.value;
-        if(job_index < jobs_pushed.value) {
-            if(SDL_AtomicCAS(&next_job, job_index, job_index + 1)) {
-                ThreadJob *job = jobs + job_index;
-                job->run(job->args);
-                SDL_AtomicIncRef(&jobs_done);
-            }
+    u32 worker = (u32)(uintptr_t)data;
+    SDL_TLSSet(worker_tls, (void *)(uintptr_t)(worker + 1), NULL);
+
+    JobDeque *deque = deques + worker;
+
+    while(SDL_AtomicGet(&running.value)) {
+        ThreadJob job;
+        if(job_get(deque, &job)) {
+            job_run(&job);
         } else {
             SDL_SemWait(semaphore);
         }
@@ -57,16 +258,55 @@ static int thread_do_jobs(void *data) {
     return 0;
 }
 
-void job_system_initialize(void) {
-    semaphore = SDL_CreateSemaphore(0);
+void job_system_initialize(u32 thread_count) {
+    semaphore       = SDL_CreateSemaphore(0);
+    injection.mutex = SDL_CreateMutex();
+    if(!worker_tls) {
+        worker_tls = SDL_TLSCreate();
+    }
 
-    for(u32 thread_index = 0; thread_index < MAX_WORKER_THREADS; ++thread_index) {
+    // NOTE: with zero worker threads job_queue_end runs every job on the calling thread
+    if(thread_count > MAX_WORKER_THREADS) {
+        thread_count = MAX_WORKER_THREADS;
+    }
+
+    deque_count = thread_count + 1;
+    for(u32 i = 0; i < deque_count; ++i) {
+        JobDeque *deque = deques + i;
+        SDL_AtomicSet(&deque->top.value, 0);
+        SDL_AtomicSet(&deque->bottom.value, 0);
+        deque->random_state = 0x9e3779b9u * (i + 1);
+    }
+    SDL_TLSSet(worker_tls, (void *)(uintptr_t)1, NULL);
+
+    SDL_AtomicSet(&jobs_completed.value, 0);
+    SDL_AtomicSet(&jobs_cancelled.value, 0);
+
+    SDL_AtomicSet(&running.value, 1);
+    thread_pool_count = thread_count;
+    for(u32 thread_index = 0; thread_index < thread_count; ++thread_index) {
         SDL_Thread **thread = thread_pool + thread_index;
-        *thread             = SDL_CreateThread(thread_do_jobs, NULL, NULL);
+        *thread = SDL_CreateThread(thread_do_jobs, NULL, (void *)(uintptr_t)(thread_index + 1));
     }
 }
 
 void job_system_terminate(void) {
+    SDL_AtomicSet(&running.value, 0);
+    for(u32 thread_index = 0; thread_index < thread_pool_count; ++thread_index) {
+        SDL_SemPost(semaphore);
+    }
+    for(u32 thread_index = 0; thread_index < thread_pool_count; ++thread_index) {
+        SDL_WaitThread(thread_pool[thread_index], NULL);
+        thread_pool[thread_index] = NULL;
+    }
+    thread_pool_count = 0;
+
+    SDL_TLSSet(worker_tls, NULL, NULL);
+
+    free(injection.jobs);
+    SDL_DestroyMutex(injection.mutex);
+    memset(&injection, 0, sizeof(injection));
+
     SDL_DestroySemaphore(semaphore);
 }
 
@@ -2,17 +2,43 @@
 #define _JOB_H_
 
 #include "common.h"
+#include "os.h"
 
 #define MAX_WORKER_THREADS 7
 
+// NOTE: Cancellation flag of a job. A cancelled job is skipped when it is popped, and a running
+// job can check it at its stage boundaries and return JOB_CANCELLED
+typedef struct JobHandle {
+    SDL_atomic_t cancelled;
+} JobHandle;
+
+#define JOB_DONE 0
+#define JOB_CANCELLED 1
+
 typedef struct ThreadJob {
     int (*run)(void *data);
     void *args;
+    JobHandle *handle; // NOTE: Optional, NULL for jobs that cannot be cancelled
 } ThreadJob;
 
-#define MAX_THREAD_JOBS 1024
+// NOTE: The counters are 32 bit atomics and wrap, take rates from the u32 difference of two reads
+typedef struct JobStats {
+    u32 completed;
+    u32 cancelled;
+} JobStats;
+
+// NOTE: Jobs each thread can hold in its own deque (power of two), the rest overflow to the
+// injection queue that grows as needed
+#define JOB_DEQUE_SIZE 1024
+
+// NOTE: Dependency counter, its job is pushed when the counter reaches zero. Initialize it with
+// the number of jobs (or events) the job waits for, each one decrements it once from any thread
+typedef struct JobCounter {
+    SDL_atomic_t value;
+    ThreadJob job;
+} JobCounter;
 
-void job_system_initialize(void);
+void job_system_initialize(u32 thread_count);
 void job_system_terminate(void);
 
 void job_queue_begin(void);
@@ -20,4 +46,15 @@ void job_queue_end(void);
 
 void push_job(ThreadJob job);
 
+void job_handle_reset(JobHandle *handle);
+void job_cancel(JobHandle *handle);
+b32 job_is_cancelled(JobHandle *handle);
+
+// NOTE: Jobs run since the job system was initialized
+JobStats job_get_stats(void);
+
+void job_counter_initialize(JobCounter *counter, u32 count, ThreadJob job);
+// NOTE: Returns true if this was the last dependency and the job was pushed
+b32 job_counter_decrement(JobCounter *counter);
+
 #endif // _JOB_H_
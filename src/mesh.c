@@ -0,0 +1,164 @@
+#include "os.h"
+#include "mesh.h"
+
+// NOTE: Mesh staging pool ----------------------------------------------
+
+typedef struct MeshBlock {
+    struct MeshBlock *next;
+    u32 size_class;
+    u32 padding;
+} MeshBlock;
+
+typedef struct MeshSizeClass {
+    SDL_SpinLock lock;
+    MeshBlock *free_blocks;
+    u32 cached_count;
+    SDL_atomic_t used_count;
+} MeshSizeClass;
+
+static MeshSizeClass size_classes[MESH_SIZE_CLASS_COUNT];
+
+static_assert(sizeof(MeshBlock) == MESH_BLOCK_HEADER_SIZE, "MESH_BLOCK_HEADER_SIZE is stale");
+
+static SDL_atomic_t used_size;
+static SDL_atomic_t cached_size;
+static SDL_atomic_t peak_used_size;
+
+static inline u32 mesh_class_size(u32 size_class) {
+    return MESH_MIN_BLOCK_SIZE << size_class;
+}
+
+static inline u32 mesh_class_capacity(u32 size_class) {
+    return (mesh_class_size(size_class) - MESH_BLOCK_HEADER_SIZE) / sizeof(Vertex);
+}
+
+static u32 mesh_size_class_from_count(u32 vertex_count) {
+    u32 size_class = 0;
+    while(mesh_class_capacity(size_class) < vertex_count) {
+        ++size_class;
+        assert(size_class < MESH_SIZE_CLASS_COUNT);
+    }
+    return size_class;
+}
+
+static void mesh_track_used(s32 size) {
+    s32 used = SDL_AtomicAdd(&used_size, size) + size;
+    s32 peak = SDL_AtomicGet(&peak_used_size);
+    while(used > peak && !SDL_AtomicCAS(&peak_used_size, peak, used)) {
+        peak = SDL_AtomicGet(&peak_used_size);
+    }
+}
+
+static Vertex *mesh_alloc_from_class(u32 size_class, u32 *vertex_capacity) {
+    MeshSizeClass *sc = size_classes + size_class;
+    u32 size          = mesh_class_size(size_class);
+
+    SDL_AtomicLock(&sc->lock);
+    MeshBlock *block = sc->free_blocks;
+    if(block) {
+        sc->free_blocks = block->next;
+        sc->cached_count -= 1;
+    }
+    SDL_AtomicUnlock(&sc->lock);
+
+    if(block) {
+        SDL_AtomicAdd(&cached_size, -(s32)size);
+    } else {
+        block = (MeshBlock *)malloc(size);
+        if(!block) {
+            printf("Error allocating mesh staging block (%u bytes)\n", size);
+            exit(-1);
+        }
+    }
+
+    block->next       = NULL;
+    block->size_class = size_class;
+
+    SDL_AtomicIncRef(&sc->used_count);
+    mesh_track_used((s32)size);
+
+    *vertex_capacity = mesh_class_capacity(size_class);
+    return (Vertex *)(block + 1);
+}
+
+Vertex *mesh_alloc(u32 vertex_count, u32 *vertex_capacity) {
+    return mesh_alloc_from_class(mesh_size_class_from_count(vertex_count), vertex_capacity);
+}
+
+Vertex *mesh_grow(Vertex *vertices, u32 vertex_count, u32 *vertex_capacity) {
+    if(!vertices) {
+        return mesh_alloc(vertex_count, vertex_capacity);
+    }
+
+    MeshBlock *block = (MeshBlock *)vertices - 1;
+    if(mesh_class_capacity(block->size_class) >= vertex_count) {
+        *vertex_capacity = mesh_class_capacity(block->size_class);
+        return vertices;
+    }
+
+    u32 size_class = mesh_size_class_from_count(vertex_count);
+    Vertex *result = mesh_alloc_from_class(size_class, vertex_capacity);
+    memcpy(result, vertices, mesh_class_capacity(block->size_class) * sizeof(Vertex));
+    mesh_free(vertices);
+
+    return result;
+}
+
+void mesh_free(Vertex *vertices) {
+    if(!vertices) {
+        return;
+    }
+
+    MeshBlock *block  = (MeshBlock *)vertices - 1;
+    MeshSizeClass *sc = size_classes + block->size_class;
+    u32 size          = mesh_class_size(block->size_class);
+
+    SDL_AtomicAdd(&sc->used_count, -1);
+    mesh_track_used(-(s32)size);
+
+    // NOTE: Keep the block around for the next mesh unless the cache is already full. The space is
+    // reserved before the block is cached so concurrent frees cannot go over the limit together
+    s32 cached_after = SDL_AtomicAdd(&cached_size, (s32)size) + (s32)size;
+    if(cached_after > MESH_MAX_CACHED_SIZE) {
+        SDL_AtomicAdd(&cached_size, -(s32)size);
+        free(block);
+        return;
+    }
+
+    SDL_AtomicLock(&sc->lock);
+    block->next     = sc->free_blocks;
+    sc->free_blocks = block;
+    sc->cached_count += 1;
+    SDL_AtomicUnlock(&sc->lock);
+}
+
+void mesh_pool_terminate(void) {
+    for(u32 size_class = 0; size_class < MESH_SIZE_CLASS_COUNT; ++size_class) {
+        MeshSizeClass *sc = size_classes + size_class;
+
+        SDL_AtomicLock(&sc->lock);
+        MeshBlock *block = sc->free_blocks;
+        while(block) {
+            MeshBlock *next = block->next;
+            SDL_AtomicAdd(&cached_size, -(s32)mesh_class_size(size_class));
+            free(block);
+            block = next;
+        }
+        sc->free_blocks  = NULL;
+        sc->cached_count = 0;
+        SDL_AtomicUnlock(&sc->lock);
+    }
+}
+
+MeshPoolStats mesh_pool_get_stats(void) {
+    MeshPoolStats stats;
+    stats.used_size      = (u64)SDL_AtomicGet(&used_size);
+    stats.cached_size    = (u64)SDL_AtomicGet(&cached_size);
+    stats.peak_used_size = (u64)SDL_AtomicGet(&peak_used_size);
+    for(u32 size_class = 0; size_class < MESH_SIZE_CLASS_COUNT; ++size_class) {
+        stats.block_count[size_class] = (u32)SDL_AtomicGet(&size_classes[size_class].used_count);
+    }
+    return stats;
+}
+
+// ----------------------------------------------------------------------
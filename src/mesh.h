@@ -0,0 +1,33 @@
+#ifndef _MESH_H_
+#define _MESH_H_
+
+#include "gpu.h"
+
+// NOTE: Staging memory for chunk meshes. Meshes live here from the moment they are generated
+// until they are uploaded to the gpu, blocks come in power of two size classes and freed blocks
+// are cached (up to MESH_MAX_CACHED_SIZE) to be reused by the next meshes
+
+#define MESH_MIN_BLOCK_SIZE (4 * 1024)
+#define MESH_SIZE_CLASS_COUNT 9 // NOTE: 4KB to 1MB blocks
+#define MESH_MAX_CACHED_SIZE (16 * 1024 * 1024)
+
+// NOTE: Every block starts with its header, the biggest mesh is the capacity of the largest block
+#define MESH_BLOCK_HEADER_SIZE 16
+#define MESH_MAX_BLOCK_SIZE (MESH_MIN_BLOCK_SIZE << (MESH_SIZE_CLASS_COUNT - 1))
+#define MESH_MAX_VERTICES ((MESH_MAX_BLOCK_SIZE - MESH_BLOCK_HEADER_SIZE) / sizeof(Vertex))
+
+typedef struct MeshPoolStats {
+    u64 used_size;
+    u64 cached_size;
+    u64 peak_used_size;
+    u32 block_count[MESH_SIZE_CLASS_COUNT];
+} MeshPoolStats;
+
+Vertex *mesh_alloc(u32 vertex_count, u32 *vertex_capacity);
+Vertex *mesh_grow(Vertex *vertices, u32 vertex_count, u32 *vertex_capacity);
+void mesh_free(Vertex *vertices);
+
+void mesh_pool_terminate(void);
+MeshPoolStats mesh_pool_get_stats(void);
+
+#endif // _MESH_H_
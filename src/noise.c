@@ -0,0 +1,150 @@
+#include "noise.h"
+
+#define STB_PERLIN_IMPLEMENTATION
+#include <stb_perlin.h>
+
+#if NOISE_SSE2
+#include <emmintrin.h>
+#endif
+
+// NOTE: Perlin noise ---------------------------------------------------
+
+static f32 noise_gradients[12][3] = {
+    { 1, 1, 0 },
+    { -1, 1, 0 },
+    { 1, -1, 0 },
+    { -1, -1, 0 },
+    { 1, 0, 1 },
+    { -1, 0, 1 },
+    { 1, 0, -1 },
+    { -1, 0, -1 },
+    { 0, 1, 1 },
+    { 0, -1, 1 },
+    { 0, 1, -1 },
+    { 0, -1, -1 },
+};
+
+void noise_perlin3_batch_scalar(f32 *out, f32 *x, f32 *y, f32 *z, u32 count, u8 seed) {
+    for(u32 i = 0; i < count; ++i) {
+        out[i] = stb_perlin_noise3_internal(x[i], y[i], z[i], 0, 0, 0, seed);
+    }
+}
+
+#if NOISE_SSE2
+
+// NOTE: Same operations in the same order as stb so every lane matches the scalar result
+static inline __m128 noise_floor4(__m128 a, __m128i *out_floor) {
+    __m128i ai   = _mm_cvttps_epi32(a);
+    __m128 af    = _mm_cvtepi32_ps(ai);
+    __m128i less = _mm_castps_si128(_mm_cmplt_ps(a, af));
+    ai           = _mm_add_epi32(ai, less);
+    *out_floor   = ai;
+    return _mm_cvtepi32_ps(ai);
+}
+
+static inline __m128 noise_ease4(__m128 a) {
+    __m128 t = _mm_sub_ps(_mm_mul_ps(a, _mm_set1_ps(6)), _mm_set1_ps(15));
+    t        = _mm_add_ps(_mm_mul_ps(t, a), _mm_set1_ps(10));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, a), a), a);
+}
+
+static inline __m128 noise_lerp4(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+static inline __m128 noise_grad4(u8 *grad_idx, __m128 x, __m128 y, __m128 z) {
+    f32 *g0 = noise_gradients[grad_idx[0]];
+    f32 *g1 = noise_gradients[grad_idx[1]];
+    f32 *g2 = noise_gradients[grad_idx[2]];
+    f32 *g3 = noise_gradients[grad_idx[3]];
+    __m128 gx = _mm_setr_ps(g0[0], g1[0], g2[0], g3[0]);
+    __m128 gy = _mm_setr_ps(g0[1], g1[1], g2[1], g3[1]);
+    __m128 gz = _mm_setr_ps(g0[2], g1[2], g2[2], g3[2]);
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, x), _mm_mul_ps(gy, y)), _mm_mul_ps(gz, z));
+}
+
+static void noise_perlin3_4(f32 *out, f32 *in_x, f32 *in_y, f32 *in_z, u8 seed) {
+    __m128i px, py, pz;
+    __m128 x = _mm_loadu_ps(in_x);
+    __m128 y = _mm_loadu_ps(in_y);
+    __m128 z = _mm_loadu_ps(in_z);
+    x        = _mm_sub_ps(x, noise_floor4(x, &px));
+    y        = _mm_sub_ps(y, noise_floor4(y, &py));
+    z        = _mm_sub_ps(z, noise_floor4(z, &pz));
+
+    __m128 u = noise_ease4(x);
+    __m128 v = noise_ease4(y);
+    __m128 w = noise_ease4(z);
+
+    // NOTE: The permutation table lookups have no SSE2 gather, they stay scalar per lane
+    __m128i mask = _mm_set1_epi32(255);
+    __m128i one  = _mm_set1_epi32(1);
+    s32 x0[4], x1[4], y0[4], y1[4], z0[4], z1[4];
+    _mm_storeu_si128((__m128i *)x0, _mm_and_si128(px, mask));
+    _mm_storeu_si128((__m128i *)x1, _mm_and_si128(_mm_add_epi32(px, one), mask));
+    _mm_storeu_si128((__m128i *)y0, _mm_and_si128(py, mask));
+    _mm_storeu_si128((__m128i *)y1, _mm_and_si128(_mm_add_epi32(py, one), mask));
+    _mm_storeu_si128((__m128i *)z0, _mm_and_si128(pz, mask));
+    _mm_storeu_si128((__m128i *)z1, _mm_and_si128(_mm_add_epi32(pz, one), mask));
+
+    u8 grad_idx[8][4];
+    for(u32 lane = 0; lane < 4; ++lane) {
+        s32 r0  = stb__perlin_randtab[x0[lane] + seed];
+        s32 r1  = stb__perlin_randtab[x1[lane] + seed];
+        s32 r00 = stb__perlin_randtab[r0 + y0[lane]];
+        s32 r01 = stb__perlin_randtab[r0 + y1[lane]];
+        s32 r10 = stb__perlin_randtab[r1 + y0[lane]];
+        s32 r11 = stb__perlin_randtab[r1 + y1[lane]];
+
+        grad_idx[0][lane] = stb__perlin_randtab_grad_idx[r00 + z0[lane]];
+        grad_idx[1][lane] = stb__perlin_randtab_grad_idx[r00 + z1[lane]];
+        grad_idx[2][lane] = stb__perlin_randtab_grad_idx[r01 + z0[lane]];
+        grad_idx[3][lane] = stb__perlin_randtab_grad_idx[r01 + z1[lane]];
+        grad_idx[4][lane] = stb__perlin_randtab_grad_idx[r10 + z0[lane]];
+        grad_idx[5][lane] = stb__perlin_randtab_grad_idx[r10 + z1[lane]];
+        grad_idx[6][lane] = stb__perlin_randtab_grad_idx[r11 + z0[lane]];
+        grad_idx[7][lane] = stb__perlin_randtab_grad_idx[r11 + z1[lane]];
+    }
+
+    __m128 ones = _mm_set1_ps(1);
+    __m128 xm1  = _mm_sub_ps(x, ones);
+    __m128 ym1  = _mm_sub_ps(y, ones);
+    __m128 zm1  = _mm_sub_ps(z, ones);
+
+    __m128 n000 = noise_grad4(grad_idx[0], x, y, z);
+    __m128 n001 = noise_grad4(grad_idx[1], x, y, zm1);
+    __m128 n010 = noise_grad4(grad_idx[2], x, ym1, z);
+    __m128 n011 = noise_grad4(grad_idx[3], x, ym1, zm1);
+    __m128 n100 = noise_grad4(grad_idx[4], xm1, y, z);
+    __m128 n101 = noise_grad4(grad_idx[5], xm1, y, zm1);
+    __m128 n110 = noise_grad4(grad_idx[6], xm1, ym1, z);
+    __m128 n111 = noise_grad4(grad_idx[7], xm1, ym1, zm1);
+
+    __m128 n00 = noise_lerp4(n000, n001, w);
+    __m128 n01 = noise_lerp4(n010, n011, w);
+    __m128 n10 = noise_lerp4(n100, n101, w);
+    __m128 n11 = noise_lerp4(n110, n111, w);
+
+    __m128 n0 = noise_lerp4(n00, n01, v);
+    __m128 n1 = noise_lerp4(n10, n11, v);
+
+    _mm_storeu_ps(out, noise_lerp4(n0, n1, u));
+}
+
+void noise_perlin3_batch(f32 *out, f32 *x, f32 *y, f32 *z, u32 count, u8 seed) {
+    u32 i = 0;
+    for(; i + 4 <= count; i += 4) {
+        noise_perlin3_4(out + i, x + i, y + i, z + i, seed);
+    }
+    noise_perlin3_batch_scalar(out + i, x + i, y + i, z + i, count - i, seed);
+}
+
+#else
+
+void noise_perlin3_batch(f32 *out, f32 *x, f32 *y, f32 *z, u32 count, u8 seed) {
+    noise_perlin3_batch_scalar(out, x, y, z, count, seed);
+}
+
+#endif
+
+// ----------------------------------------------------------------------
@@ -0,0 +1,19 @@
+#ifndef _NOISE_H_
+#define _NOISE_H_
+
+#include "common.h"
+
+// NOTE: Batched version of stb_perlin_noise3_seed (no wrapping), evaluates the noise at count
+// points at once. Uses SSE2 lanes when the target has them and falls back to one stb call per
+// point otherwise, both paths return the same values as stb_perlin_noise3_seed
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_SSE2 1
+#else
+#define NOISE_SSE2 0
+#endif
+
+void noise_perlin3_batch(f32 *out, f32 *x, f32 *y, f32 *z, u32 count, u8 seed);
+void noise_perlin3_batch_scalar(f32 *out, f32 *x, f32 *y, f32 *z, u32 count, u8 seed);
+
+#endif // _NOISE_H_
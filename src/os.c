@@ -1,6 +1,7 @@
 #include <glad/glad.h>
 
 #include "os.h"
+#include "gpu.h"
 
 static SDL_Window *window = NULL;
 static SDL_GLContext context;
@@ -56,14 +57,11 @@ void os_window_initialize(u32 w, u32 h) {
 
     SDL_GL_SetSwapInterval(1);
 
-    glEnable(GL_DEPTH_TEST);
-
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    gpu_enable_depth_and_culling();
 
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    glViewport(0, 0, w, h);
+    gpu_set_viewport(0, 0, w, h);
 }
 
 void os_window_terminate(void) {
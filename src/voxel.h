@@ -9,10 +9,6 @@
 #define ATLAS_ROWS (ATLAS_H / TILE_DIM)
 #define ATLAS_COLS (ATLAS_W / TILE_DIM)
 
-typedef struct R2 {
-    V2 min, max;
-} R2;
-
 typedef enum VoxelType {
     VOXEL_AIR,
     VOXEL_DIRT,
@@ -39,7 +35,7 @@ typedef enum VoxelBockFace {
 } VoxelBlockFace;
 
 typedef struct VoxelBlock {
-    R2 coords[VOXEL_BLOCK_FACE_COUNT];
+    u8 tiles[VOXEL_BLOCK_FACE_COUNT];
 } VoxelBlock;
 
 typedef struct Voxel {
@@ -48,19 +44,10 @@ typedef struct Voxel {
 
 #define VOXEL_DIM 1.0f
 
-static inline R2 get_tile(u32 x, u32 y) {
-    R2 result;
-    result.min.x = (f32)(x * TILE_DIM) / (f32)ATLAS_W;
-    result.min.y = (f32)(y * TILE_DIM) / (f32)ATLAS_H;
-    result.max.x = (f32)(x * TILE_DIM + TILE_DIM) / (f32)ATLAS_W;
-    result.max.y = (f32)(y * TILE_DIM + TILE_DIM) / (f32)ATLAS_H;
-    // TODO: SDL2 dont have a flip surface function, load image with stb instead of fliping
-    // coordinates
-    f32 tmp      = result.min.y;
-    result.min.y = result.max.y;
-    result.max.y = tmp;
-
-    return result;
+// NOTE: Tiles are stored as an index into the atlas, the shader maps it to texture coordinates
+static inline u8 get_tile(u32 x, u32 y) {
+    assert(x < ATLAS_COLS && y < ATLAS_ROWS);
+    return (u8)(y * ATLAS_COLS + x);
 }
 
 void voxel_block_map_initialize(void);